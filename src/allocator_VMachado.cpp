@@ -14,22 +14,53 @@ input commands like the following space separated or tab separated commands exam
 
 	a. RQ P3 1024 B		Requests memory for P3 using best fit strategy for 1024 bytes allocation.
 						Case there is not enough memory, user is warned, request is rejected.
+						Other strategies are F first fit, N next fit, W worst fit and U buddy.
 
 	b. RL P3			Releases the memory allocated to P3.
 						Case P3 is not a valid name for allocated process, the user is warned and release is rejected.
 
+	   RS P3 2048		Resizes P3 to 2048 bytes, in place case it shrinks or the bytes after it are free, otherwise
+						it moves to the best fit gap. Prints whether it moved. Processes in slabs or buddy zones can not be resized.
+
 	c. STAT				Prints status of memory, start and final byte, and either process number or FREE if memory is not allocated.
 
+	   STAT SHARD 2		Prints the status of shard 2 only, with --shards.
+
+	   STAT 0 4095		Prints only the processes and free gaps holding bytes 0 to 4095.
+
+	   STAT JSON		Prints the status as one JSON object per line. Also STAT 0 4095 JSON and STAT SHARD 2 JSON.
+
+	   METRICS			Prints the bytes used and free, the regions, free gaps and largest free block, the external
+						fragmentation, the allocations, failed allocations and releases and the resizes and those done in place so far, without walking memory.
+
 	d. C				Compacts the memory by shifting free space towards the higher bytes in memory.
 
+	   C STEP 4096		Compacts incrementally, moving about 4096 bytes per step. Commands keep working between steps.
+
+	   C PLAN			Compacts moving as few bytes as possible, filling gaps with processes from the top of memory.
+						Prints the bytes and processes moved next to what C would move.
+
+	   C SHARD 2		Compacts shard 2 only, with --shards. The other shards are not blocked.
+
+	   C BACKGROUND		Compacts on a worker thread, commands and STAT keep working on the current layout. The compacted
+						layout is swapped in at the first command after it is built, printing the swap pause. Processes
+						requested meanwhile move right after the compacted ones. Does not combine with --wal or --shards.
+
+	   C WAIT			Waits for the background compaction and swaps it in.
+
 	e. QUIT				Quits the program.
 
 	f. HELP				Prints program usage during runtime, program does not quit.
 
+	g. SAVE heap.snap	Saves the processes and their names in the binary snapshot file heap.snap, which --load
+						maps at startup. Memory with --slabs, --buddy or --shards can not be saved.
+
+	h. PING				Replies PONG. Clients of --serve end a pipelined batch with it, RQ and RL reply nothing case they succeed.
+
 
 	Note: All commands are case sensitive and preferably should not contain spaces in the beginning or
-		  end of input line for guaranteed execution. For this project, B strategy, best fit, is the only
-		  option and any other value passed other than B for the fourth item of RQ will cause
+		  end of input line for guaranteed execution. The strategy options are B best fit, F first fit,
+		  N next fit, W worst fit and U buddy, with --buddy, any other value passed for the fourth item of RQ will cause
 		  allocation to be rejected. Multiple space and tab trimming for input line was implemented, but
 		  single space separation between entries in the line is still preferred for optimal execution.
 
@@ -38,8 +69,42 @@ input commands like the following space separated or tab separated commands exam
 			g++ -c VMapp.exe allocator_VMachado.o  Links the object file to executable.
 			./VMapp.exe 1048576                    Runs and allocates 1MB for the allocator app.
             ./VMapp.exe -help                      Prints usage information
+			./VMapp.exe 1048576 --replay trace.txt Replays the commands in trace.txt without prompts.
+			./VMapp.exe 1048576 --pipe < trace.txt Replays the commands piped to standard input without prompts.
+			PS: Batch modes buffer all output and print the throughput in commands per second at the end.
+			./VMapp.exe 1048576 --bench            Runs the synthetic benchmark and prints latency percentiles.
+			PS: Benchmark options are --dist uniform|powerlaw|bimodal, --release lifo|fifo|random,
+				--occupancy <0..1>, --ops <n>, --min <bytes>, --max <bytes>, --seed <n> and
+				--step <bytes> to take an incremental compaction step between operations,
+				--compact slide|plan to compact like C or like C PLAN, --fit B|F|N|W|U for the strategy,
+				--threads <n> to measure the concurrent allocator with 1, 2, 4, ... up to n worker threads,
+				--extents <n> to compare best fit in the SIMD extent table and in the list for 256, 1024, ... up to n processes.
+			./VMapp.exe 1048576 --arena            Backs the memory with a real arena. RQ prints the handle of
+				the process bytes and C moves the bytes and prints the bandwidth. Works with --bench too.
+			./VMapp.exe 1048576 --auto-compact 4096 Runs a compaction step of about 4096 bytes after every command.
+			./VMapp.exe 1048576 --slabs            Serves requests up to 2048 bytes from 64KB slabs of power of two
+				size classes. STAT shows the slabs, the processes in them and the slab hit rate.
+			./VMapp.exe 1048576 --buddy 262144     Serves RQ with strategy U from buddy zones of 262144 bytes. STAT shows
+				the blocks of every zone and the internal fragmentation.
+			./VMapp.exe 1048576 --shards 4         Splits the memory in 4 shards with their own process lists and locks. RQ goes
+				to the shard picked by the name, or to the next shard with room case it is full. STAT shows
+				every shard. Shards hold at least 4096 bytes. Does not combine with --arena or --bench.
+			./VMapp.exe 1048576 --load heap.snap   Starts with the processes saved by SAVE in heap.snap, mapped and
+				loaded with no parsing. The memory must hold every process. Does not combine with --shards.
+			./VMapp.exe 1048576 --wal heap.log     Logs RQ, RL, RS and C in heap.log, with a checkpoint in heap.log.snap once the log
+				outgrows it, or every n commands with --checkpoint <n>. At startup the checkpoint is loaded and the
+				log replayed, so a crashed allocator comes back where it was. Does not combine with --slabs, --buddy,
+				--shards, --arena, --load or --bench.
+			./VMapp.exe 1048576 --serve 7000       Serves the commands of many clients on localhost TCP port 7000, or on a Unix
+				socket when the value is a path, from one epoll thread. Clients may pipeline commands and replies
+				come back in order. Between lines a client may send binary batches of RQ and RL with numeric ids,
+				answered with one array of results, see WireOp. A line over 4096 bytes closes the client, QUIT closes
+				the client only, Ctrl-C stops the server.
+			./VMapp.exe 1048576 --client 7000      Drives the server on port 7000 and prints the throughput and the
+				round trip percentiles. Options are --connections <n>, --pipeline <n> commands per batch and
+				--commands <n> per connection, and --binary to send binary batches. The memory size is not used.
 			PS: 1MB is lowest value allowed and will get overwritten to 1048576. Any value
-				over 1048576 will extend memory.
+				over 1048576 will extend memory, up to 1152921504606846976, or 1EB.
 
 	Memory slot range:     [ 0      :   argv[1] - 1 ]
 
@@ -53,408 +118,2524 @@ input commands like the following space separated or tab separated commands exam
 #include <sstream>
 #include <limits>
 #include <stdio.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <chrono>
+#include <streambuf>
+#include <climits>
+#include <cstring>
+#include <cstddef>
+#include <new>
+#include <string_view>
+#include <charconv>
+#include <set>
+#include <map>
+#include <vector>
+#include <deque>
+#include <random>
+#include <algorithm>
+#include <cmath>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <unordered_map>
+#include <cerrno>
+#include <csignal>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/epoll.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
 
 
 //============================================================================
 /*
- * Process class
- * Defines instance data and methods needed to instantiate and manipulate Processes
+ * Address - a byte address or a size in bytes of the simulated memory. 64 bit,
+ * so memories are not capped below 2GB.
  */
+typedef long long Address;
 
-class Process
+/*
+ * addressWidth - digits needed to print addresses up to last, at least 7, so
+ * STAT keeps its columns aligned for any memory size
+ */
+inline int addressWidth(Address last)
 {
-private:
-	//instance data
-	std::string processNumber;
-		int size;
-		int firstByte;
-		int lastByte;
-		Process * next;
+	int width = 1;
+	for (; last >= 10; last /= 10)
+		width++;
+	return width < 7 ? 7 : width > 19 ? 19 : width;
+}
 
-		//Targeted encapsulation
-		friend class LinkedList;
-public:
+/*
+ * writeExtent - writes the start of a STAT line for the bytes [first : last] to
+ * out, as "Address [ first : last ]" in columns of width digits, or as the first
+ * fields of a JSON object case json is true. Case parent is not -1 the bytes are
+ * held in the slab or buddy zone starting at parent: text is indented and JSON
+ * names the parent.
+ */
+inline void writeExtent(std::ostream & out, Address first, Address last, int width, bool json, Address parent = -1)
+{
+	char buffer[100];
+	if (json && parent >= 0)
+		snprintf(buffer, sizeof(buffer), "{\"first\":%lld,\"last\":%lld,\"parent\":%lld", first, last, parent);
+	else if (json)
+		snprintf(buffer, sizeof(buffer), "{\"first\":%lld,\"last\":%lld", first, last);
+	else
+		snprintf(buffer, sizeof(buffer), "%sAddress [ %*lld : %*lld ]", parent >= 0 ? "    " : "", width, first, width, last);
+	out << buffer;
+}
 
-	/**
-	 * Process constructor accepts process name and size needed for allocation
-	 */
-	Process(std::string num, int s)
+/*
+ * writeProcessName - ends a STAT line started by writeExtent for a process with
+ * the name. JSON escapes the name, any byte but a space can be in it.
+ */
+inline void writeProcessName(std::ostream & out, const std::string & name, bool json)
+{
+	if (!json)
 	{
-		processNumber = num;
-		size = s;
-		firstByte = 0;
-		lastByte = 0;
-		next = NULL;
+		out << " Process " << name << "\n";
+		return;
 	}
-
-	/**
-	 * toString - returns a formatted string with the process' instance data
-	 */
-	std::string toString()
+	out << ",\"type\":\"process\",\"name\":\"";
+	for (std::size_t i = 0; i < name.size(); i++)
 	{
-		std::stringstream ss;
-		char buffer[50];
-		sprintf(buffer, "%7d : %7d", firstByte, lastByte);
-		ss << "Address [ " << buffer << " ] Process " << processNumber;
-		return ss.str();
+		unsigned char c = name[i];
+		if (c == '"' || c == '\\')
+			out << '\\' << c;
+		else if (c < 0x20)
+		{
+			char escape[8];
+			snprintf(escape, sizeof(escape), "\\u%04x", c);
+			out << escape;
+		}
+		else
+			out << c;
 	}
+	out << "\"}\n";
+}
+
+//============================================================================
+/*
+ * Slab - a process sized extent carved out of memory for small requests of one
+ * size class. It is split into slots of classSize bytes, each one holding one
+ * small process or NULL when free. See SizeClasses class.
+ */
+class Process;
+struct Slab
+{
+	Process * extent;                 //process in the linked list that reserves the slab bytes
+	int sizeClass;                    //index of the size class
+	int classSize;                    //bytes in each slot
+	int used;                         //slots holding a process
+	std::vector<Process *> objects;   //process in each slot, NULL when free
+	std::vector<int> freeSlots;       //free slots, the next one to use at the back
+	int partialIndex;                 //position in the list of slabs with free slots of its class, -1 when full
 };
 
-//===========================================================================
+//============================================================================
 /*
- * Linked List class
- * Defines the instance data and methods needed to create a linked list
- * to serve as a list of processes allocated in a memory slot
+ * BuddyZone - a process sized extent carved out of memory for buddy allocation.
+ * Its bytes are split into power of two blocks, see BuddyZones class.
  */
+struct BuddyZone
+{
+	Process * extent;                   //process in the linked list that reserves the zone bytes
+	int id;                             //position in the zone table
+	int order;                          //zone size is 2 ^ order bytes
+	std::map<int, Process *> objects;   //process held in every block in use, by offset
+	std::map<int, int> freeBlocks;      //order of every free block, by offset
+};
 
-class LinkedList
+//============================================================================
+/*
+ * NameTable class - interns process names into small integer ids, so a process
+ * keeps an int instead of its own string. Every id counts the processes using
+ * it and is given out again once none does.
+ */
+class NameTable
 {
 private:
-	//instance data
-	Process * head;
-	int number;    //added a tracker variable, so far unused, but well implemented
-public:
-	/*
-	 * LinkedList constructor
-	 * Instantiates a linked lists with head and tail having NULL values.
-	 */
-	LinkedList()
-	{
-		head = NULL;
-		number = 0;
-	}
+	std::deque<std::string> names;                    //name of every id, never moves in memory
+	std::vector<int> uses;                            //processes using every id, 0 when it is free
+	std::vector<int> freeIds;
+	std::unordered_map<std::string_view, int> ids;    //id of every name in use, views into names
 
-	/*
-	 * addProcessToList -  adds the Process passed as parameter to the
-	 * linked list at the specified position. Process is added either to:
-	 * 		. empty linked list
-	 * 		.not empty linked list
-	 *
-	 * Those two scenarios are analyzed before adding Process
-	 * Method is called after findSpotInList() returning the best fit place in linked list.
-	 * NULL processes are rejected.
+public:
+	/**
+	 * intern - returns the id of name, giving it one case it has none, and counts one more use
 	 */
-	void addProcessToList(Process * p, int position)
+	int intern(std::string_view name)
 	{
-		//std::cout << "PUT AT POSITION " << position << "\n";
-		//rejects NULL processes
-		if (p == NULL)
-			return;
-
-		//case position is zero, there can be processes after or list can be empty
-		Process * traverse = head;
-		if (position == 0)
+		std::unordered_map<std::string_view, int>::iterator found = ids.find(name);
+		if (found != ids.end())
 		{
-			if(head == NULL) //empty list
-			{
-				head = p;
-				p->firstByte = 0;
-				p->lastByte = p-> size - 1;
-			}
-			else  			//not empty list
-			{
-				p->firstByte = 0;
-				p->lastByte = p-> size - 1;
-				p->next = head;
-				head = p;
-			}
-			return;
+			uses[found->second]++;
+			return found->second;
 		}
-
-		//otherwise iterate to position
-		int tracker = 0;
-		while(tracker != (position - 1))
+		int id;
+		if (freeIds.empty())
 		{
-			traverse = traverse->next;
-			tracker++;
+			id = (int) names.size();
+			names.emplace_back(name);
+			uses.push_back(0);
+		}
+		else
+		{
+			id = freeIds.back();
+			freeIds.pop_back();
+			names[id].assign(name.data(), name.size());
 		}
+		uses[id] = 1;
+		ids[names[id]] = id;
+		return id;
+	}
 
-		//update instance data for new process
-		p->firstByte = traverse->lastByte+1;
-		p->lastByte = p->firstByte + p->size - 1;
-		p->next = traverse->next;
-		traverse->next = p;
-		number++;
-		return;
+	/**
+	 * use - counts one more use of id, which must be in use
+	 */
+	void use(int id)
+	{
+		uses[id]++;
 	}
 
-	/*
-	 * removeProcessbyNumber - removes a process in the linked list by processNumber
-	 * A Process to be deleted can be either in
-	 * 		. head
-	 * 		. tail
-	 * 		. middle
-	 *
-	 * 	Those three cases are inspected to perform a deletion.
-	 * 	The process name must match in order to delete (p1, p2, ...)
-	 *
-	 *  deleteProcess: indicates if process removed must also be deleted (deallocated).
-	 *  Returns the size of the process removed, or -1 if the process does not exist
-	 *  in the list of allocated processes
+	/**
+	 * reserve - makes room for count more names, so interning them does not rehash
 	 */
-	int removeProcessByNumber(std::string procNum, bool deleteProcess)
+	void reserve(std::size_t count)
 	{
-		//traverser and follower
-		Process *traverse = head;
-		Process *previous = head;
+		ids.reserve(ids.size() + count);
+		uses.reserve(uses.size() + count);
+	}
 
-		//traverse the linked list searching for process name
-		while (traverse != NULL)
+	/**
+	 * release - counts one use less of id, which is free again after its last use
+	 */
+	void release(int id)
+	{
+		if (--uses[id] == 0)
 		{
-			//case a match
-			if ((procNum.compare(traverse->processNumber)) == 0)
-			{
-				//case match in the head
-				if (traverse == head)
-				{
-					if (head->next != NULL) //case head is not the only process
-						head = head->next;
-					else
-						head = NULL;		//case head was the only one process
-				}
-
-				//case match is in the middle or end
-				else
-					previous->next = traverse->next;
-
-				//free memory
-				if (deleteProcess)
-				{
-					delete traverse;
-					number--;
-					return traverse->size;
-				}
-				//keep memory
-				else
-				{
-					traverse->next = NULL;
-					number--;
-					return traverse->size;
-				}
-			}
-			//otherwise step forward to compare next
-			else
-			{
-				if (traverse != head)
-					previous = previous->next;
-				traverse = traverse->next;
-			}
+			ids.erase(names[id]);
+			freeIds.push_back(id);
 		}
-		return -1; //case not a match for parameter is found
 	}
 
 	/**
-	 * findSpotInList - finds a spot in the linked list of processes to
-	 * allocate a chunk of size 'size' using the best fit strategy, leaving the
-	 * smallest possible free gap between the newly inserted process and its neighbors.
-	 * This is just a beautiful function, proud of it!
+	 * find - returns the id of name, or -1 case no process uses it
 	 */
-	int findSpotInList(int size, int max)
+	int find(std::string_view name) const
 	{
-		//if list is empty add to beginning
-		if(head == NULL)
-		{
-			if(size <= max +1)
-				return 0;    // case memory is empty and process fits
-			else
-				return -1;   //though free size > memory size. Last case to be found!
-		}
+		std::unordered_map<std::string_view, int>::const_iterator found = ids.find(name);
+		return found == ids.end() ? -1 : found->second;
+	}
 
-		//assume the gap is largest value in system
-		int leftGap = INT_MAX;
+	/**
+	 * nameOf - returns the name with id
+	 */
+	const std::string & nameOf(int id) const
+	{
+		return names[id];
+	}
+};
 
-		//winner returns -1 if there is not place in memory for the size
-		int winner = -1;
+//============================================================================
+/*
+ * Process class
+ * Defines instance data and methods needed to instantiate and manipulate Processes
+ */
 
-		//counts the hops needed to get to the best place
-		int counter = 0;
+class Process
+{
+private:
+	//instance data
+	int name;        //id of the process name in the name table of its pool
+		Address size;
+		Address firstByte;
+		Address lastByte;
+		Process * next;
+		Process * prev;
+		int handle;      //entry in the handle table of a memory backed by a real arena, -1 otherwise
 
-		//traverser
-		Process * trav = head;
+		//slab of a slab extent or of a process held in a slab, NULL otherwise.
+		//A process held in a slab keeps its first and last byte relative to the slab extent.
+		Slab * slab;
 
-		//case the first process is not using byte zero
-		if(trav->firstByte != 0)
-		{
-			int tempGap = trav->firstByte;
-			//if gap fits the size, make it the winner so far
-			if(tempGap >= size )
-			{
-				winner = 0;
-				leftGap = trav->firstByte - size;
-			}
-		}
+		//buddy zone of a zone extent or of a process held in a zone, NULL otherwise.
+		//A process held in a zone keeps its first and last byte relative to the zone extent.
+		BuddyZone * zone;
 
-		counter = 1;
+		//Targeted encapsulation
+		friend class LinkedList;
+		friend class Memory;
+		friend class SizeClasses;
+		friend class BuddyZones;
+		friend class ConcurrentMemory;
+		friend class ProcessPool;
+		friend struct ProcessAddressOrder;
+public:
+
+	/**
+	 * Process constructor accepts the id of the process name and size needed for allocation.
+	 * Processes are made by a ProcessPool, which interns the name.
+	 */
+	Process(int n, Address s)
+	{
+		name = n;
+		size = s;
+		firstByte = 0;
+		lastByte = 0;
+		next = NULL;
+		prev = NULL;
+		handle = -1;
+		slab = NULL;
+		zone = NULL;
+	}
 
-		//other spaces are checking in a fragmented memory
-		while(trav != NULL)
+	/**
+	 * write - writes a STAT line with the process' instance data to out, as text
+	 * or as a JSON object case json is true. A slab extent writes its size class
+	 * and usage, and a zone extent its size, followed by a line for every process
+	 * or free block it holds. Addresses are written plus base, in columns of width
+	 * digits, and names are looked up in names.
+	 */
+	void write(std::ostream & out, const NameTable & names, Address base, int width, bool json)
+	{
+		Address first = base + firstByte;
+		writeExtent(out, first, base + lastByte, width, json);
+		if (zone != NULL)
 		{
-			//if you get to the end, see if last byte of last process is last byte in memory
-			if(trav->next == NULL)
+			if (json)
+				out << ",\"type\":\"zone\",\"bytes\":" << size << "}\n";
+			else
+				out << " Buddy zone " << size << " bytes\n";
+
+			//blocks in use and free blocks in address order
+			std::map<int, Process *>::iterator used = zone->objects.begin();
+			std::map<int, int>::iterator free = zone->freeBlocks.begin();
+			while (used != zone->objects.end() || free != zone->freeBlocks.end())
 			{
-				int tempGap = max - trav->lastByte;
-				if(tempGap >= size && tempGap - size < leftGap)
+				if (free == zone->freeBlocks.end() || (used != zone->objects.end() && used->first < free->first))
 				{
-					winner = counter; //set hops to here
-					leftGap = tempGap - size;
+					int block = 16;
+					while (block < used->second->size)
+						block *= 2;
+					writeExtent(out, first + used->first, first + used->first + block - 1, width, json, first);
+					writeProcessName(out, names.nameOf(used->second->name), json);
+					++used;
 				}
-			}
-			//case the match is in a gap betwen processes
-			else if(trav->lastByte < trav->next->firstByte -1)
-			{
-				int tempGap = trav->next->firstByte - trav->lastByte - 1;
-				if(tempGap >= size && tempGap - size < leftGap)
+				else
 				{
-					winner = counter; //set hops to here
-					leftGap = tempGap - size;
+					writeExtent(out, first + free->first, first + free->first + (1 << free->second) - 1, width, json, first);
+					out << (json ? ",\"type\":\"free\"}\n" : " Free\n");
+					++free;
 				}
 			}
-			counter++; //increment hop
-			trav = trav->next;
-		}
-		return winner;
-	}
-
-	/*
-	 * toString - Return a string with data for the Processes in the linked list
-	 * by calling the toString defined in class Process. Case there are not processes
-	 * it returns free. Another beautiful method ;)
-	 */
-	std::string toString(int max)
-	{
-		std::stringstream ss;
-		ss << "\n";
-
-		Process * traverse = head;
-		//case the list is  totally empty
-		if (traverse == NULL)
-		{
-			char buffer[25];
-			sprintf(buffer, "%7d : %7d", 0, max);
-			ss << "Address [ " << buffer << " ] " << "Free\n\n";
-			return ss.str();
+			return;
 		}
-		int delimiter = 0;
-
-		//traverse to produce printouts
-		while (traverse != NULL)
+		if (slab == NULL)
 		{
-			//case there is not gap between adjacent processes, print process, update delimiter
-			if(traverse->firstByte == delimiter)
-			{
-				ss << traverse->toString() << "\n";
-				delimiter = traverse->lastByte + 1;
-			}
-			//case there is a gap between adjacent processes, update delimiter, print gap and process.
-			else
-			{
-				char buffer[50];
-				sprintf(buffer, "%7d : %7d", delimiter, traverse->firstByte - 1);
-				ss << "Address [ " << buffer << " ] " << "Free\n";
-				ss << traverse->toString() << "\n";
-				delimiter = traverse->lastByte + 1;
-			}
-			//step forward
-			traverse = traverse->next;
+			writeProcessName(out, names.nameOf(name), json);
+			return;
 		}
-		//case the last process is not using the last available byte, print last gap
-		if(delimiter != max + 1)
+		if (json)
+			out << ",\"type\":\"slab\",\"classSize\":" << slab->classSize << ",\"used\":" << slab->used
+					<< ",\"slots\":" << slab->objects.size() << "}\n";
+		else
+			out << " Slab " << slab->classSize << " bytes, " << slab->used << " of " << slab->objects.size() << " slots used\n";
+		for (std::size_t i = 0; i < slab->objects.size(); i++)
 		{
-			char buffer[50];
-			sprintf(buffer, "%7d : %7d", delimiter, max);
-			ss << "Address [ " << buffer << " ] " << "Free\n";
+			Process * object = slab->objects[i];
+			if (object == NULL)
+				continue;
+			writeExtent(out, first + object->firstByte, first + object->lastByte, width, json, first);
+			writeProcessName(out, names.nameOf(object->name), json);
 		}
-		ss << "\n";
-		return ss.str();
 	}
+};
 
-	/*
-	 * compactProcesses - compacts the processes in the list towards the low memory
-	 * bytes, placed side by side without gap and leaving free memory, if any,
-	 * towards the high bytes in memory
-	 */
-	void compactProcesses(int lastByte)
-	{
-		//if list is empty, no compaction needed
-		if(head == NULL)
-			return;
-
-		//traverser through the processes in the list
-		Process  * trav = head;
-
-		//custom update the first process addresses
-		trav->firstByte = 0;
-		trav->lastByte = trav->size + trav->firstByte - 1;
+/*
+ * ProcessAddressOrder - orders processes by first byte, so processes sharing
+ * a name are kept from low memory to high memory. Sets ordered by it can also
+ * be searched by an address.
+ */
+struct ProcessAddressOrder
+{
+	typedef void is_transparent;
 
-		//set delimiter for iterations
-		int nextFirst = trav->lastByte + 1;
-		trav = trav->next;
+	bool operator()(const Process * a, const Process * b) const
+	{
+		return a->firstByte < b->firstByte;
+	}
 
-		//iterate throught the processes and update the first and last byte for each one, update the delimiter
-		while(trav != NULL)
-		{
-			trav->firstByte = nextFirst;
-			trav->lastByte = trav->size + trav->firstByte - 1;
-			nextFirst = trav->lastByte + 1; //delimiter
-			trav = trav->next;
-		}
+	bool operator()(const Process * a, Address b) const
+	{
+		return a->firstByte < b;
 	}
 
-}; //end of LinkedList class
+	bool operator()(Address a, const Process * b) const
+	{
+		return a < b->firstByte;
+	}
+};
 
-//======================================================================
+//============================================================================
 /*
- *  Memory class- defines the instance data and methods needed to
- * instantiate manipulate a linear chunk of memory
+ * ProcessPool class - makes the processes of a memory out of blocks of
+ * records, so a request takes no heap allocation once the pool has grown and
+ * processes sit next to each other. Released records are kept on a free list
+ * for the next request. Names are interned in the name table of the pool.
+ * Records are only given back to the system when the pool is deallocated.
  */
-class Memory
+class ProcessPool
 {
-
 private:
-	LinkedList processes;
-	int max;
+	static const int blockRecords = 1024;
 
-public:
+	std::vector<Process *> blocks;   //storage of blockRecords processes each
+	Process * freeList;              //released records, linked through next
+	Process * retired;               //records released while held, reused after reclaim
+	bool holding;
+	NameTable table;
+
+	//disable copies, the blocks are owned by one pool
+	ProcessPool(const ProcessPool &);
+	ProcessPool & operator=(const ProcessPool &);
 
 	/*
-	 * Memory constructor - defined the number of available bytes to be allocated.
-	 * Note the value - 1 is passed into constructor to account for the max - 1
-	 * memory requirement
+	 * record - takes a record off the free list, carving a new block case no record is free
 	 */
-	Memory(int m)
-{
-		max = m;
-}
-	/**
-	 * findMemorySlot - Finds available memory for required
-	 * size using the  best fit strategy. Calls the linked list method
-	 * that seeks the best place for the process with required size.
-	 * Passes max to it so process list know the last byte to
-	 * be analyzed.
-	 */ 
-	int findMemorySlot(int sizeRequired)
+	Process * record()
 	{
-		return processes.findSpotInList(sizeRequired, max);
+		if (freeList == NULL)
+		{
+			Process * block = (Process *) ::operator new(sizeof(Process) * blockRecords);
+			blocks.push_back(block);
+			for (int i = blockRecords - 1; i >= 0; i--)
+			{
+				new (block + i) Process(-1, 0);
+				block[i].next = freeList;
+				freeList = block + i;
+			}
+		}
+		Process * p = freeList;
+		freeList = p->next;
+		return p;
 	}
 
-
+public:
 	/**
-	 * toString - returns a string with the information specified in
-	 * the assignment
-	 */ 
-	std::string toString()
+	 * ProcessPool constructor - no blocks yet
+	 */
+	ProcessPool()
 	{
-		return processes.toString(max);
+		freeList = NULL;
+		retired = NULL;
+		holding = false;
 	}
 
 	/**
-	 * addProcessToMemory - adds a process location specified by place
-	 * parameter. Used after findMemorySlot returns the best fit location
-	 * for the process.
-	 */ 
-	void addProcessToMemory(Process * p, int place)
+	 * ProcessPool destructor - gives the blocks back, processes still in use go with them
+	 */
+	~ProcessPool()
 	{
-		processes.addProcessToList(p, place);
+		for (std::size_t i = 0; i < blocks.size(); i++)
+			::operator delete(blocks[i]);
+	}
+
+	/**
+	 * create - returns a new process with the name and size
+	 */
+	Process * create(std::string_view name, Address size)
+	{
+		return new (record()) Process(table.intern(name), size);
+	}
+
+	/**
+	 * create - returns a new process with the name of id, which must be in use,
+	 * and size. Saves looking the name up when many processes share it.
+	 */
+	Process * create(int id, Address size)
+	{
+		table.use(id);
+		return new (record()) Process(id, size);
+	}
+
+	/**
+	 * intern - returns the id of name, kept in use until release is called
+	 */
+	int intern(std::string_view name)
+	{
+		return table.intern(name);
+	}
+
+	/**
+	 * release - releases a use of id taken by intern
+	 */
+	void release(int id)
+	{
+		table.release(id);
+	}
+
+	/**
+	 * reserve - makes room for count more names
+	 */
+	void reserve(std::size_t count)
+	{
+		table.reserve(count);
+	}
+
+	/**
+	 * destroy - releases p and its name, the record is reused by a later create.
+	 * While the pool is held the record is retired instead, its name is -1 until reclaim.
+	 */
+	void destroy(Process * p)
+	{
+		table.release(p->name);
+		p->name = -1;
+		if (holding)
+		{
+			p->next = retired;
+			retired = p;
+			return;
+		}
+		p->next = freeList;
+		freeList = p;
+	}
+
+	/**
+	 * hold - keeps released records from being reused, so pointers taken before
+	 * stay unique and tell by their name whether the process was released
+	 */
+	void hold()
+	{
+		holding = true;
+	}
+
+	/**
+	 * retiredRecords - returns the records released since hold, linked through next
+	 */
+	Process * retiredRecords() const
+	{
+		return retired;
+	}
+
+	/**
+	 * adopt - takes over block, records made outside the pool that are all in
+	 * use. Their names must be in use already, by records they replace.
+	 */
+	void adopt(Process * block)
+	{
+		blocks.push_back(block);
+	}
+
+	/**
+	 * recycle - takes back the records from first to last, linked through next,
+	 * without releasing their names, which were released or handed on already
+	 */
+	void recycle(Process * first, Process * last)
+	{
+		last->next = freeList;
+		freeList = first;
+	}
+
+	/**
+	 * reclaim - ends the hold, the retired records are reused from now on
+	 */
+	void reclaim()
+	{
+		while (retired != NULL)
+		{
+			Process * p = retired;
+			retired = p->next;
+			p->next = freeList;
+			freeList = p;
+		}
+		holding = false;
+	}
+
+	/**
+	 * find - returns the id of name, or -1 case no process has it
+	 */
+	int find(std::string_view name) const
+	{
+		return table.find(name);
+	}
+
+	/**
+	 * names - returns the name table of the pool
+	 */
+	const NameTable & names() const
+	{
+		return table;
+	}
+};
+
+//============================================================================
+/*
+ * Snapshot file - the processes of a memory and their names, written by SAVE and
+ * read by --load. The file is flat, so it is mapped and read in place:
+ * 		SnapshotHeader
+ * 		SnapshotRegion for every process, in address order
+ * 		offset of every name in the name bytes, and of their end, as Address
+ * 		name bytes
+ * Names are numbered from 0 in the order of first use. Numbers are in the byte
+ * order of the machine that wrote the file.
+ */
+struct SnapshotHeader
+{
+	char magic[8];             //"VMSNAP" and two zero bytes
+	int version;               //snapshotVersion when written
+	int regionBytes;           //size of SnapshotRegion when written
+	Address max;               //last byte of the memory saved
+	Address sequence;          //commands of the write-ahead log the snapshot covers, 0 for SAVE
+	Address regions;
+	Address names;
+	Address nameBytes;
+};
+
+struct SnapshotRegion
+{
+	Address firstByte;
+	Address size;
+	Address name;              //number of the name in the file
+};
+
+static const char snapshotMagic[8] = { 'V', 'M', 'S', 'N', 'A', 'P', 0, 0 };
+static const int snapshotVersion = 2;
+
+/*
+ * Binary wire protocol of --serve. A client may send, between text lines, a
+ * batch frame: a WireHeader with the request magic and count WireOp records.
+ * The server applies the whole batch and answers with a WireHeader with the
+ * reply magic and count Address results, in the order of the operations:
+ * 		RQ    first byte given to the process, -1 case there is no room
+ * 		RL    0, -1 case no process has the id
+ * 		other -2, the operation is not valid
+ * Processes are named by numeric ids below wireIds, and the name of id is its
+ * decimal digits, so text commands and STAT see them too. Frames start with a
+ * zero byte, which no text line does. Numbers are in the byte order of the machine.
+ */
+struct WireHeader
+{
+	char magic[4];
+	int count;                 //operations in the batch, at most wireBatch
+};
+
+struct WireOp
+{
+	int id;
+	char op;                   //'R' request, 'L' release
+	char strategy;             //B, F, N, W or U for RQ
+	short unused;
+	Address size;              //bytes for RQ
+};
+
+static const char wireRequest[4] = { 0, 'V', 'M', 'B' };
+static const char wireReply[4] = { 0, 'V', 'M', 'R' };
+static const int wireBatch = 1 << 20;
+static const int wireIds = 1 << 24;
+
+//placement policies, defined after the LinkedList class
+struct BestFit;
+struct FirstFit;
+struct NextFit;
+struct WorstFit;
+struct WalkBestFit;
+
+//===========================================================================
+/*
+ * Linked List class
+ * Defines the instance data and methods needed to create a linked list
+ * to serve as a list of processes allocated in a memory slot
+ */
+
+class LinkedList
+{
+private:
+	//instance data
+	Process * head;
+	int number;    //processes in the list
+	Address used;  //bytes held by the processes in the list
+	Address max;   //last byte available in memory
+	ProcessPool * pool;   //pool the processes of the list come from
+
+	//incremental compaction progress, processes up to this one sit side by side from byte 0. NULL when none do.
+	Process * compactCursor;
+
+	//last process allocated, next fit resumes its search after it. NULL for the start of memory.
+	Process * rover;
+
+	//placement policies search the free gaps directly
+	friend struct BestFit;
+	friend struct FirstFit;
+	friend struct NextFit;
+	friend struct WorstFit;
+	friend struct WalkBestFit;
+
+	//index of free gaps ordered by (size, first byte), best fit is the first gap not smaller than the request.
+	//Each gap maps to the process right before it, NULL for a gap starting at byte 0.
+	std::map<std::pair<Address, Address>, Process *> freeGaps;
+
+	//index from process name to the processes holding it, lowest address first
+	std::unordered_map<int, std::set<Process *, ProcessAddressOrder> > byName;
+
+	//every process in address order, so STAT of a range finds its first process in O(log n).
+	//Compaction slides processes keeping their order, so the index stays valid.
+	std::set<Process *, ProcessAddressOrder> byAddress;
+
+	/*
+	 * addGap - inserts the free gap [first : last] that follows process previous
+	 * into the free gap index. Empty gaps are ignored.
+	 */
+	void addGap(Address first, Address last, Process * previous)
+	{
+		if (last >= first)
+			freeGaps[std::make_pair(last - first + 1, first)] = previous;
+	}
+
+	/*
+	 * gapAfter - returns the size of the free gap right after process previous,
+	 * or before the head when previous is NULL, and sets first to its first byte.
+	 * Size is 0 case there is no gap.
+	 */
+	Address gapAfter(Process * previous, Address & first)
+	{
+		Process * successor = after(previous);
+		first = (previous == NULL) ? 0 : previous->lastByte + 1;
+		Address last = (successor == NULL) ? max : successor->firstByte - 1;
+		return last - first + 1;
+	}
+
+	/*
+	 * after - returns the process right after previous, or the head when previous is NULL
+	 */
+	Process * after(Process * previous)
+	{
+		return (previous == NULL) ? head : previous->next;
+	}
+
+	/*
+	 * removeGap - removes the free gap [first : last] from the free gap index.
+	 * Empty gaps are ignored.
+	 */
+	void removeGap(Address first, Address last)
+	{
+		if (last >= first)
+			freeGaps.erase(std::make_pair(last - first + 1, first));
+	}
+
+public:
+	/*
+	 * Slot - handle to a free gap returned by findSpotInList. Holds the first
+	 * byte of the gap, -1 when there is no room, and the process right before
+	 * the gap, NULL when the gap starts at byte 0.
+	 * Slots handed out by the size classes of Memory name the slab with a free
+	 * slot instead, slab is NULL for every other slot. Slots handed out by the
+	 * buddy zones of Memory name the zone of the free block the same way.
+	 */
+	struct Slot
+	{
+		Address firstByte;
+		Process * previous;
+		Slab * slab;
+		BuddyZone * zone;
+	};
+
+	/*
+	 * CompactionReport - what a planned compaction moved, next to what sliding
+	 * every process down, as compactProcesses does, would have moved.
+	 */
+	struct CompactionReport
+	{
+		long bytesMoved;
+		int regionsMoved;
+		long slideBytes;
+		int slideRegions;
+	};
+
+	/*
+	 * LinkedList constructor
+	 * Instantiates a linked lists with head and tail having NULL values.
+	 * The whole memory [0 : m] starts as a single free gap. Processes come
+	 * from pool p and go back to it when deleted.
+	 */
+	LinkedList(Address m, ProcessPool * p)
+	{
+		head = NULL;
+		number = 0;
+		used = 0;
+		max = m;
+		pool = p;
+		compactCursor = NULL;
+		rover = NULL;
+		addGap(0, max, NULL);
+	}
+
+	/*
+	 * addProcessToList -  adds the Process passed as parameter to the
+	 * linked list in the free gap specified by slot. Process is added either to:
+	 * 		. empty linked list or before the head
+	 * 		.not empty linked list, right after slot.previous
+	 *
+	 * Those two scenarios are analyzed before adding Process
+	 * Method is called after findSpotInList() returning the best fit slot in memory,
+	 * the slot already knows its neighbors so no list traversal is needed.
+	 * The free gap holding the process is shrunk in the free gap index.
+	 * NULL processes are rejected.
+	 */
+	void addProcessToList(Process * p, Slot slot)
+	{
+		//rejects NULL processes
+		if (p == NULL)
+			return;
+
+		p->firstByte = slot.firstByte;
+		p->lastByte = p->firstByte + p->size - 1;
+
+		//successor is the head when the gap starts at byte 0, or list can be empty
+		Process * successor = (slot.previous == NULL) ? head : slot.previous->next;
+
+		//shrink the gap between the neighbors, what is left follows the new process.
+		//A slot from slotAt may start inside the gap, the bytes before it stay free.
+		Address gapStart = (slot.previous == NULL) ? 0 : slot.previous->lastByte + 1;
+		Address gapEnd = (successor == NULL) ? max : successor->firstByte - 1;
+		removeGap(gapStart, gapEnd);
+		addGap(gapStart, slot.firstByte - 1, slot.previous);
+		addGap(p->lastByte + 1, gapEnd, p);
+
+		//update instance data for new process and its neighbors
+		p->prev = slot.previous;
+		p->next = successor;
+		if (successor != NULL)
+			successor->prev = p;
+		if (slot.previous == NULL)
+			head = p;
+		else
+			slot.previous->next = p;
+		byName[p->name].insert(p);
+		byAddress.insert(p);
+		rover = p;
+		number++;
+		used += p->size;
+		return;
+	}
+
+	/*
+	 * removeProcessbyNumber - removes a process in the linked list by the id of its name
+	 * A Process to be deleted can be either in
+	 * 		. head
+	 * 		. tail
+	 * 		. middle
+	 *
+	 * 	The process is found through the name index and unlinked through its
+	 * 	neighbours, so no list traversal is needed.
+	 * 	The process name must match in order to delete (p1, p2, ...)
+	 * 	Case processes share the name, the one in lowest memory is removed.
+	 * 	The freed bytes are merged with the free gaps around them in the free gap index.
+	 *
+	 *  deleteProcess: indicates if process removed must also be deleted (deallocated).
+	 *  Returns the size of the process removed, or -1 if the process does not exist
+	 *  in the list of allocated processes
+	 */
+	Address removeProcessByNumber(int procNum, bool deleteProcess)
+	{
+		//case not a match for parameter is found
+		Process * target = findProcessByNumber(procNum);
+		if (target == NULL)
+			return -1;
+		return removeProcess(target, deleteProcess);
+	}
+
+	/*
+	 * removeProcess - removes the process target, which must be in the list,
+	 * the same way removeProcessByNumber does once it found the process.
+	 *  Returns the size of the process removed.
+	 */
+	Address removeProcess(Process * target, bool deleteProcess)
+	{
+		//drop the name once its last process is gone
+		std::unordered_map<int, std::set<Process *, ProcessAddressOrder> >::iterator match = byName.find(target->name);
+		match->second.erase(target);
+		if (match->second.empty())
+			byName.erase(match);
+		byAddress.erase(target);
+
+		//merge the gaps on both sides of the process into a single free gap
+		Address gapStart = (target->prev == NULL) ? 0 : target->prev->lastByte + 1;
+		Address gapEnd = (target->next == NULL) ? max : target->next->firstByte - 1;
+		removeGap(gapStart, target->firstByte - 1);
+		removeGap(target->lastByte + 1, gapEnd);
+		addGap(gapStart, gapEnd, target->prev);
+
+		//case match in the head, otherwise match is in the middle or end
+		if (target == head)
+			head = target->next;
+		else
+			target->prev->next = target->next;
+		if (target->next != NULL)
+			target->next->prev = target->prev;
+
+		//case the process is in the compacted prefix, the prefix now ends right before it
+		if (compactCursor != NULL && target->firstByte <= compactCursor->firstByte)
+			compactCursor = target->prev;
+
+		//case next fit was to resume after the process, resume after its predecessor
+		if (rover == target)
+			rover = target->prev;
+
+		Address size = target->size;
+		number--;
+		used -= size;
+
+		//free memory
+		if (deleteProcess)
+			pool->destroy(target);
+		//keep memory
+		else
+		{
+			target->next = NULL;
+			target->prev = NULL;
+		}
+		return size;
+	}
+
+	/*
+	 * resizeInPlace - resizes target, which must be in the list, to size bytes
+	 * without moving it. Shrinking always fits, the bytes given up join the gap
+	 * after it. Growing takes bytes from the free gap right after it. Returns
+	 * false, changing nothing, case that gap is too small. Case a process of the
+	 * compacted prefix shrinks, the prefix ends at it, the gap left after it has
+	 * to be compacted again.
+	 */
+	bool resizeInPlace(Process * target, Address size)
+	{
+		Address gapFirst;
+		Address gap = gapAfter(target, gapFirst);
+		if (size > target->size + gap)
+			return false;
+		Address gapEnd = gapFirst + gap - 1;
+		removeGap(gapFirst, gapEnd);
+		if (size < target->size && compactCursor != NULL && target->firstByte <= compactCursor->firstByte)
+			compactCursor = target;
+		used += size - target->size;
+		target->size = size;
+		target->lastByte = target->firstByte + size - 1;
+		addGap(target->lastByte + 1, gapEnd, target);
+		return true;
+	}
+
+	/**
+	 * findSpotInList - finds a spot in memory to allocate a chunk of size 'size'
+	 * using the placement policy, best fit by default. Each policy is a template
+	 * parameter, so its search is compiled in place without virtual calls.
+	 * Returns a handle to the chosen gap, with first byte -1 if no gap fits.
+	 */
+	template <class Policy = BestFit>
+	Slot findSpotInList(Address size)
+	{
+		return Policy::find(*this, size);
+	}
+
+	/*
+	 * write - writes the processes and free gaps holding any byte in [from : to]
+	 * to out by calling the write defined in class Process, as STAT text or as
+	 * JSON lines case json is true. Case there are not processes it writes free.
+	 * The first process of the range is found in the address index and the list is
+	 * walked from there, so only the lines written are visited, O(log n + k).
+	 * Addresses are written plus base, the first byte of a shard, in columns
+	 * wide enough for the last byte. Text starts and ends with an empty line.
+	 */
+	void write(std::ostream & out, Address max, Address base, Address from, Address to, bool json)
+	{
+		int width = addressWidth(base + max);
+		if (!json)
+			out << "\n";
+
+		//first process ending at or after from, it may start before from
+		std::set<Process *, ProcessAddressOrder>::iterator first = byAddress.upper_bound(from);
+		if (first != byAddress.begin())
+		{
+			--first;
+			if ((*first)->lastByte < from)
+				++first;
+		}
+		Process * traverse = (first == byAddress.end()) ? NULL : *first;
+
+		//delimiter for iterations, first byte after the process before traverse
+		Address delimiter = 0;
+		if (traverse != NULL && traverse->prev != NULL)
+			delimiter = traverse->prev->lastByte + 1;
+		else if (traverse == NULL && !byAddress.empty())
+			delimiter = (*byAddress.rbegin())->lastByte + 1;
+
+		while (true)
+		{
+			//case there is a gap before the next process, or before the end of memory, in the range
+			Address gapEnd = (traverse == NULL) ? max : traverse->firstByte - 1;
+			if (gapEnd >= delimiter && gapEnd >= from && delimiter <= to)
+			{
+				writeExtent(out, base + delimiter, base + gapEnd, width, json);
+				out << (json ? ",\"type\":\"free\"}\n" : " Free\n");
+			}
+			if (traverse == NULL || traverse->firstByte > to)
+				break;
+			traverse->write(out, pool->names(), base, width, json);
+			delimiter = traverse->lastByte + 1;
+			traverse = traverse->next;
+		}
+		if (!json)
+			out << "\n";
+	}
+
+	/*
+	 * slotAt - returns the slot for size bytes from first, found in the address
+	 * index, with first byte -1 case any of those bytes is not free
+	 */
+	Slot slotAt(Address first, Address size)
+	{
+		Slot slot = { -1, NULL, NULL, NULL };
+		std::set<Process *, ProcessAddressOrder>::iterator successor = byAddress.upper_bound(first);
+		Process * previous = NULL;
+		if (successor != byAddress.begin())
+		{
+			std::set<Process *, ProcessAddressOrder>::iterator before = successor;
+			previous = *--before;
+		}
+		Address gapFirst = (previous == NULL) ? 0 : previous->lastByte + 1;
+		Address gapLast = (successor == byAddress.end()) ? max : (*successor)->firstByte - 1;
+		if (size > 0 && first >= gapFirst && first <= gapLast && size <= gapLast - first + 1)
+		{
+			slot.firstByte = first;
+			slot.previous = previous;
+		}
+		return slot;
+	}
+
+	/*
+	 * save - writes the processes of the list and their names to out in the
+	 * snapshot format, with max as the last byte of the memory and sequence as
+	 * the log commands it covers. Returns false case writing fails.
+	 */
+	bool save(std::ostream & out, Address max, Address sequence)
+	{
+		//number the names in the order of first use
+		int highest = -1;
+		for (Process * trav = head; trav != NULL; trav = trav->next)
+			highest = std::max(highest, trav->name);
+		std::vector<int> renumber(highest + 1, -1);
+		std::vector<int> order;
+		Address nameBytes = 0;
+		for (Process * trav = head; trav != NULL; trav = trav->next)
+			if (renumber[trav->name] < 0)
+			{
+				renumber[trav->name] = (int) order.size();
+				order.push_back(trav->name);
+				nameBytes += pool->names().nameOf(trav->name).size();
+			}
+
+		SnapshotHeader header;
+		memcpy(header.magic, snapshotMagic, sizeof(header.magic));
+		header.version = snapshotVersion;
+		header.regionBytes = sizeof(SnapshotRegion);
+		header.max = max;
+		header.sequence = sequence;
+		header.regions = number;
+		header.names = (Address) order.size();
+		header.nameBytes = nameBytes;
+		out.write((const char *) &header, sizeof(header));
+
+		for (Process * trav = head; trav != NULL; trav = trav->next)
+		{
+			SnapshotRegion region = { trav->firstByte, trav->size, renumber[trav->name] };
+			out.write((const char *) &region, sizeof(region));
+		}
+		Address offset = 0;
+		for (std::size_t i = 0; i <= order.size(); i++)
+		{
+			out.write((const char *) &offset, sizeof(offset));
+			if (i < order.size())
+				offset += pool->names().nameOf(order[i]).size();
+		}
+		for (std::size_t i = 0; i < order.size(); i++)
+			out << pool->names().nameOf(order[i]);
+		return out.good();
+	}
+
+	/*
+	 * load - links the processes in order, which have their first byte set, are
+	 * in address order and do not overlap, into the empty list. names is the
+	 * number of different names among them. Every index is
+	 * built in one pass, inserting at its end, and the free gaps are sorted
+	 * before they are indexed, so millions of processes load with no search.
+	 */
+	void load(const std::vector<Process *> & order, std::size_t names)
+	{
+		byName.reserve(names);
+		std::vector<std::pair<std::pair<Address, Address>, Process *> > gaps;
+		Process * last = NULL;
+		Address nextFirst = 0;
+		for (std::size_t i = 0; i < order.size(); i++)
+		{
+			Process * p = order[i];
+			p->lastByte = p->firstByte + p->size - 1;
+			if (p->firstByte > nextFirst)
+				gaps.push_back(std::make_pair(std::make_pair(p->firstByte - nextFirst, nextFirst), last));
+			p->prev = last;
+			p->next = NULL;
+			if (last == NULL)
+				head = p;
+			else
+				last->next = p;
+			std::set<Process *, ProcessAddressOrder> & sameName = byName[p->name];
+			sameName.insert(sameName.end(), p);
+			byAddress.insert(byAddress.end(), p);
+			used += p->size;
+			number++;
+			nextFirst = p->lastByte + 1;
+			last = p;
+		}
+		if (nextFirst <= max)
+			gaps.push_back(std::make_pair(std::make_pair(max - nextFirst + 1, nextFirst), last));
+
+		std::sort(gaps.begin(), gaps.end());
+		freeGaps.clear();
+		for (std::size_t i = 0; i < gaps.size(); i++)
+			freeGaps.insert(freeGaps.end(), gaps[i]);
+	}
+
+	/*
+	 * compactProcesses - compacts the processes in the list towards the low memory
+	 * bytes, placed side by side without gap and leaving free memory, if any,
+	 * towards the high bytes in memory. The free gap index is rebuilt with
+	 * the single remaining gap. Processes keep their order, so the name index
+	 * stays valid.
+	 * Case arena is not NULL, the bytes of every moved process are copied to
+	 * their new place in it. Returns the number of bytes moved.
+	 */
+	long compactProcesses(Address lastByte, char * arena)
+	{
+		long moved = 0;
+
+		//delimiter for iterations, next process starts right after the previous one
+		Address nextFirst = 0;
+		Process * last = NULL;
+
+		//iterate throught the processes and update the first and last byte for each one, update the delimiter
+		for (Process * trav = head; trav != NULL; trav = trav->next)
+		{
+			if (trav->firstByte != nextFirst)
+			{
+				//processes only slide down in address order, so memmove never overwrites bytes still to be moved
+				if (arena != NULL)
+					memmove(arena + nextFirst, arena + trav->firstByte, trav->size);
+				moved += trav->size;
+				trav->firstByte = nextFirst;
+				trav->lastByte = trav->size + trav->firstByte - 1;
+			}
+			nextFirst = trav->lastByte + 1; //delimiter
+			last = trav;
+		}
+
+		//all free memory is now a single gap at the high bytes, after the last process
+		freeGaps.clear();
+		addGap(nextFirst, max, last);
+		compactCursor = last;
+		return moved;
+	}
+
+	/*
+	 * compactStep - one step of incremental compaction. Continues sliding processes
+	 * towards the low memory bytes from where the last step stopped, and stops before
+	 * moving more than budget bytes. At least one process is moved per step, so
+	 * progress is made even when a process is larger than the budget.
+	 * The free gap index is updated for every move, so requests and releases stay
+	 * correct while compaction is only partly done.
+	 * Case arena is not NULL, the bytes of every moved process are copied to their
+	 * new place in it. Returns the number of bytes moved, and regions is set to
+	 * the number of processes moved.
+	 */
+	long compactStep(long budget, char * arena, int & regions)
+	{
+		long moved = 0;
+		regions = 0;
+
+		//resume right after the compacted prefix
+		Process * trav = (compactCursor == NULL) ? head : compactCursor->next;
+		Address nextFirst = (compactCursor == NULL) ? 0 : compactCursor->lastByte + 1;
+
+		while (trav != NULL)
+		{
+			if (trav->firstByte != nextFirst)
+			{
+				//stop case the budget is used up
+				if (moved > 0 && moved + trav->size > budget)
+					break;
+
+				//the gaps before and after the process merge into one gap after its new place
+				Address gapEnd = (trav->next == NULL) ? max : trav->next->firstByte - 1;
+				removeGap(nextFirst, trav->firstByte - 1);
+				removeGap(trav->lastByte + 1, gapEnd);
+				if (arena != NULL)
+					memmove(arena + nextFirst, arena + trav->firstByte, trav->size);
+				trav->firstByte = nextFirst;
+				trav->lastByte = trav->size + trav->firstByte - 1;
+				addGap(trav->lastByte + 1, gapEnd, trav);
+				moved += trav->size;
+				regions++;
+			}
+			nextFirst = trav->lastByte + 1; //delimiter
+			compactCursor = trav;
+			trav = trav->next;
+		}
+		return moved;
+	}
+
+	/*
+	 * compactPlanned - compacts the processes towards the low memory bytes,
+	 * leaving one free gap at the high bytes like compactProcesses, but plans the
+	 * moves to copy as few bytes as possible. Processes that sit entirely above the
+	 * compacted size must move anyway, so holes are filled from the top with the
+	 * largest of them that fits, and only what is still out of place is slid down.
+	 * The plan is only run case it moves fewer bytes than sliding, otherwise
+	 * processes are slid as usual. Processes may change order, so the name index
+	 * and the list are rebuilt for the moved ones.
+	 * Case arena is not NULL, the bytes of every moved process are copied to
+	 * their new place in it. Returns what was moved and what sliding would move.
+	 */
+	CompactionReport compactPlanned(char * arena)
+	{
+		CompactionReport report = { 0, 0, 0, 0 };
+
+		//processes in address order and the compacted size
+		std::vector<Process *> order;
+		Address used = 0;
+		for (Process * trav = head; trav != NULL; trav = trav->next)
+		{
+			//sliding moves every process that does not already sit right after the previous one
+			if (trav->firstByte != used)
+			{
+				report.slideBytes += trav->size;
+				report.slideRegions++;
+			}
+			order.push_back(trav);
+			used += trav->size;
+		}
+
+		//candidates to fill holes, processes above the compacted size by size
+		std::multimap<Address, std::size_t> candidates;
+		for (std::size_t i = order.size(); i > 0 && order[i - 1]->firstByte >= used; i--)
+			candidates.insert(std::make_pair(order[i - 1]->size, i - 1));
+
+		//plan the moves in the order they can be run, each one copies into bytes already free
+		std::vector<std::pair<Process *, Address> > moves;
+		std::vector<bool> placed(order.size(), false);
+		long planBytes = 0;
+		Address cursor = 0;
+		for (std::size_t i = 0; i < order.size(); i++)
+		{
+			if (placed[i])
+				continue;
+
+			//case the process is a candidate itself, it is no longer available to fill holes
+			if (order[i]->firstByte >= used)
+			{
+				std::pair<std::multimap<Address, std::size_t>::iterator, std::multimap<Address, std::size_t>::iterator> same = candidates.equal_range(order[i]->size);
+				for (std::multimap<Address, std::size_t>::iterator it = same.first; it != same.second; ++it)
+					if (it->second == i)
+					{
+						candidates.erase(it);
+						break;
+					}
+			}
+
+			//fill the hole below this process with the largest candidates that fit
+			while (order[i]->firstByte > cursor && !candidates.empty())
+			{
+				std::multimap<Address, std::size_t>::iterator fit = candidates.upper_bound(order[i]->firstByte - cursor);
+				if (fit == candidates.begin())
+					break;
+				--fit;
+				moves.push_back(std::make_pair(order[fit->second], cursor));
+				placed[fit->second] = true;
+				planBytes += fit->first;
+				cursor += fit->first;
+				candidates.erase(fit);
+			}
+
+			//slide what is still out of place
+			if (order[i]->firstByte != cursor)
+			{
+				moves.push_back(std::make_pair(order[i], cursor));
+				planBytes += order[i]->size;
+			}
+			placed[i] = true;
+			cursor += order[i]->size;
+		}
+
+		//case the plan is not cheaper, slide as usual
+		if (planBytes >= report.slideBytes)
+		{
+			report.bytesMoved = compactProcesses(max, arena);
+			report.regionsMoved = report.slideRegions;
+			return report;
+		}
+
+		//run the plan, keeping the name index ordered while addresses change
+		for (std::size_t m = 0; m < moves.size(); m++)
+		{
+			Process * p = moves[m].first;
+			std::set<Process *, ProcessAddressOrder> & sameName = byName[p->name];
+			sameName.erase(p);
+			if (arena != NULL)
+				memmove(arena + moves[m].second, arena + p->firstByte, p->size);
+			p->firstByte = moves[m].second;
+			p->lastByte = p->firstByte + p->size - 1;
+			sameName.insert(p);
+		}
+		report.bytesMoved = planBytes;
+		report.regionsMoved = (int) moves.size();
+
+		//relink the list and rebuild the address index in the new address order
+		std::sort(order.begin(), order.end(), ProcessAddressOrder());
+		byAddress.clear();
+		Process * last = NULL;
+		for (std::size_t i = 0; i < order.size(); i++)
+		{
+			byAddress.insert(byAddress.end(), order[i]);
+			order[i]->prev = last;
+			order[i]->next = NULL;
+			if (last == NULL)
+				head = order[i];
+			else
+				last->next = order[i];
+			last = order[i];
+		}
+
+		//all free memory is now a single gap at the high bytes, after the last process
+		freeGaps.clear();
+		addGap(used, max, last);
+		compactCursor = last;
+		return report;
+	}
+
+	/*
+	 * isCompacted - returns true case there is no free gap below a process,
+	 * this is, free memory, if any, is a single gap at the high bytes.
+	 */
+	bool isCompacted()
+	{
+		if (freeGaps.empty())
+			return true;
+		if (freeGaps.size() > 1)
+			return false;
+		const std::pair<Address, Address> & gap = freeGaps.begin()->first;
+		return gap.second + gap.first - 1 == max;
+	}
+
+	/*
+	 * collect - appends the processes of the list to order, in address order
+	 */
+	void collect(std::vector<Process *> & order)
+	{
+		order.reserve(order.size() + number);
+		for (Process * trav = head; trav != NULL; trav = trav->next)
+			order.push_back(trav);
+	}
+
+	/*
+	 * appendPacked - adds p right after the last process of the list, which
+	 * must have room for it. The compacted prefix grows case the list was packed up to its last process.
+	 */
+	void appendPacked(Process * p)
+	{
+		Process * last = byAddress.empty() ? NULL : *byAddress.rbegin();
+		Slot slot = { (last == NULL) ? 0 : last->lastByte + 1, last, NULL, NULL };
+		bool packed = (last == compactCursor);
+		addProcessToList(p, slot);
+		if (packed)
+			compactCursor = p;
+	}
+
+	/*
+	 * chain - sets first and last to the first and the last process of the
+	 * list, linked through next, NULL case the list is empty
+	 */
+	void chain(Process * & first, Process * & last)
+	{
+		first = head;
+		last = byAddress.empty() ? NULL : *byAddress.rbegin();
+	}
+
+	/*
+	 * swap - exchanges the processes and the indexes of the list with those of
+	 * other in constant time, no process or index entry is copied
+	 */
+	void swap(LinkedList & other)
+	{
+		std::swap(head, other.head);
+		std::swap(number, other.number);
+		std::swap(used, other.used);
+		std::swap(max, other.max);
+		std::swap(pool, other.pool);
+		std::swap(compactCursor, other.compactCursor);
+		std::swap(rover, other.rover);
+		freeGaps.swap(other.freeGaps);
+		byName.swap(other.byName);
+		byAddress.swap(other.byAddress);
+	}
+
+	/*
+	 * usedBytes - returns the bytes held by the processes in the list
+	 */
+	Address usedBytes()
+	{
+		return used;
+	}
+
+	/*
+	 * regionCount - returns the number of processes in the list
+	 */
+	int regionCount()
+	{
+		return number;
+	}
+
+	/*
+	 * gapCount - returns the number of free gaps
+	 */
+	long gapCount()
+	{
+		return (long) freeGaps.size();
+	}
+
+	/*
+	 * largestGap - returns the size of the largest free gap, 0 case there is none
+	 */
+	Address largestGap()
+	{
+		return freeGaps.empty() ? 0 : freeGaps.rbegin()->first.first;
+	}
+
+	/*
+	 * findProcessByNumber - returns the lowest address process with the name id,
+	 * or NULL case there is none.
+	 */
+	Process * findProcessByNumber(int procNum)
+	{
+		std::unordered_map<int, std::set<Process *, ProcessAddressOrder> >::iterator match = byName.find(procNum);
+		if (match == byName.end())
+			return NULL;
+		return *match->second.begin();
+	}
+
+}; //end of LinkedList class
+
+//======================================================================
+/*
+ * SizeClasses class - front end for small requests. Sizes up to 2048 bytes are
+ * rounded up to a power of two size class, from 16 bytes, and served from slabs
+ * of 64KB carved out of memory. Each class keeps the slabs with free slots, so a
+ * small request is served in O(1) without a search of the gaps. A slab goes back
+ * to memory when its last process is released.
+ */
+class SizeClasses
+{
+private:
+	static const int classCount = 8;      //16, 32, ..., 2048 bytes
+	static const int smallestClass = 16;
+	static const int slabBytes = 65536;
+
+	//instance data, slabs with free slots of each class
+	std::vector<Slab *> partial[classCount];
+
+	//index from process name id to the processes held in slabs
+	std::unordered_map<int, std::vector<Process *> > byName;
+
+	//counters for the hit rate
+	long hits;        //small requests served from a slab already carved
+	long refills;     //small requests that carved a new slab
+	long fallbacks;   //small requests served by the gaps because no slab could be carved
+	int slabs;        //slab extents in memory
+
+	/*
+	 * removeFromPartial - takes slab out of the slabs with free slots of its class
+	 */
+	void removeFromPartial(Slab * slab)
+	{
+		std::vector<Slab *> & list = partial[slab->sizeClass];
+		list[slab->partialIndex] = list.back();
+		list[slab->partialIndex]->partialIndex = slab->partialIndex;
+		list.pop_back();
+		slab->partialIndex = -1;
+	}
+
+public:
+	/**
+	 * SizeClasses constructor - no slabs yet
+	 */
+	SizeClasses()
+	{
+		hits = 0;
+		refills = 0;
+		fallbacks = 0;
+		slabs = 0;
+	}
+
+	/**
+	 * SizeClasses destructor - deallocates the slabs. The processes they hold
+	 * belong to the process pool and the slab extents to the linked list.
+	 */
+	~SizeClasses()
+	{
+		std::set<Slab *> all;
+		for (std::unordered_map<int, std::vector<Process *> >::iterator it = byName.begin(); it != byName.end(); ++it)
+			for (std::size_t i = 0; i < it->second.size(); i++)
+				all.insert(it->second[i]->slab);
+		for (int c = 0; c < classCount; c++)
+			all.insert(partial[c].begin(), partial[c].end());
+		for (std::set<Slab *>::iterator it = all.begin(); it != all.end(); ++it)
+			delete *it;
+	}
+
+	/**
+	 * classOf - returns the size class for size bytes, or -1 case the size is not small
+	 */
+	static int classOf(Address size)
+	{
+		int sizeClass = 0;
+		for (int classSize = smallestClass; sizeClass < classCount; classSize *= 2, sizeClass++)
+			if (size <= classSize)
+				return sizeClass;
+		return -1;
+	}
+
+	/**
+	 * slabWithRoom - returns a slab of the class with a free slot, or NULL
+	 * case the class has none and a new slab must be carved
+	 */
+	Slab * slabWithRoom(int sizeClass)
+	{
+		if (partial[sizeClass].empty())
+			return NULL;
+		return partial[sizeClass].back();
+	}
+
+	/**
+	 * newSlab - turns extent, a process of slabBytes already in memory, into
+	 * an empty slab of the class. Counts a refill.
+	 */
+	Slab * newSlab(int sizeClass, Process * extent)
+	{
+		Slab * slab = new Slab;
+		slab->extent = extent;
+		slab->sizeClass = sizeClass;
+		slab->classSize = smallestClass << sizeClass;
+		slab->used = 0;
+		slab->objects.assign(slabBytes / slab->classSize, NULL);
+		for (int slot = (int) slab->objects.size() - 1; slot >= 0; slot--)
+			slab->freeSlots.push_back(slot);
+		slab->partialIndex = (int) partial[sizeClass].size();
+		partial[sizeClass].push_back(slab);
+		extent->slab = slab;
+		refills++;
+		slabs++;
+		return slab;
+	}
+
+	/**
+	 * extentBytes - bytes of memory reserved by each slab
+	 */
+	static int extentBytes()
+	{
+		return slabBytes;
+	}
+
+	/**
+	 * fallback - counts a small request served by the gaps
+	 */
+	void fallback()
+	{
+		fallbacks++;
+	}
+
+	/**
+	 * nextAddress - returns the first byte in memory of the slot the next process placed in slab takes
+	 */
+	static Address nextAddress(Slab * slab)
+	{
+		return slab->extent->firstByte + slab->freeSlots.back() * slab->classSize;
+	}
+
+	/**
+	 * place - puts process p in the next free slot of slab. Counts a hit case
+	 * the slab holds processes already, a slab just carved is empty.
+	 */
+	void place(Process * p, Slab * slab)
+	{
+		if (slab->used > 0)
+			hits++;
+		int slot = slab->freeSlots.back();
+		slab->freeSlots.pop_back();
+		slab->objects[slot] = p;
+		slab->used++;
+		p->slab = slab;
+		p->firstByte = slot * slab->classSize;
+		p->lastByte = p->firstByte + p->size - 1;
+		byName[p->name].push_back(p);
+
+		//case the slab is now full
+		if (slab->freeSlots.empty())
+			removeFromPartial(slab);
+	}
+
+	/**
+	 * addressOf - returns the first byte in memory of p, a process held in a slab
+	 */
+	static Address addressOf(Process * p)
+	{
+		return p->slab->extent->firstByte + p->firstByte;
+	}
+
+	/**
+	 * findProcessByNumber - returns the lowest address process with the name
+	 * held in a slab, or NULL case there is none.
+	 */
+	Process * findProcessByNumber(int procNum)
+	{
+		std::unordered_map<int, std::vector<Process *> >::iterator match = byName.find(procNum);
+		if (match == byName.end())
+			return NULL;
+		Process * lowest = match->second[0];
+		for (std::size_t i = 1; i < match->second.size(); i++)
+			if (addressOf(match->second[i]) < addressOf(lowest))
+				lowest = match->second[i];
+		return lowest;
+	}
+
+	/**
+	 * remove - takes p, a process held in a slab, out of its slot.
+	 * Returns the slab extent case the slab is now empty and must go back
+	 * to memory, the slab itself is deallocated then. Returns NULL otherwise.
+	 */
+	Process * remove(Process * p)
+	{
+		std::vector<Process *> & sameName = byName[p->name];
+		sameName.erase(std::find(sameName.begin(), sameName.end(), p));
+		if (sameName.empty())
+			byName.erase(p->name);
+
+		Slab * slab = p->slab;
+		int slot = (int) (p->firstByte / slab->classSize);
+		slab->objects[slot] = NULL;
+		slab->freeSlots.push_back(slot);
+		slab->used--;
+
+		//case the slab was full, it has room again
+		if (slab->partialIndex < 0)
+		{
+			slab->partialIndex = (int) partial[slab->sizeClass].size();
+			partial[slab->sizeClass].push_back(slab);
+		}
+
+		//case the slab is empty, give it back
+		if (slab->used > 0)
+			return NULL;
+		removeFromPartial(slab);
+		Process * extent = slab->extent;
+		extent->slab = NULL;
+		delete slab;
+		slabs--;
+		return extent;
+	}
+
+	/**
+	 * toString - returns a line with the slab count and the hit rate counters
+	 */
+	std::string toString()
+	{
+		std::stringstream ss;
+		long small = hits + refills + fallbacks;
+		ss << "Slabs: " << slabs << " extents, hit rate " << (small > 0 ? 100.0 * hits / small : 0)
+				<< "% (" << hits << " hits, " << refills << " refills, " << fallbacks << " fallbacks)\n";
+		return ss.str();
+	}
+};
+
+//======================================================================
+/*
+ * Placement policies - each one defines a static find method that returns
+ * the slot where a chunk of size bytes goes, with first byte -1 if no gap fits.
+ * They are passed as template parameters to LinkedList::findSpotInList.
+ */
+
+/*
+ * BestFit - the smallest gap that fits, leaving the smallest possible free gap
+ * between the newly inserted process and its neighbors. Ties go to the lowest address.
+ * The free gap index is ordered by (size, first byte), so the best fit is the
+ * first gap not smaller than size, found in O(log n).
+ */
+struct BestFit
+{
+	static LinkedList::Slot find(LinkedList & list, Address size)
+	{
+		LinkedList::Slot slot = { -1, NULL, NULL, NULL };
+		std::map<std::pair<Address, Address>, Process *>::iterator best = list.freeGaps.lower_bound(std::make_pair(size, LLONG_MIN));
+		if (best != list.freeGaps.end())
+		{
+			slot.firstByte = best->first.second;
+			slot.previous = best->second;
+		}
+		return slot;
+	}
+};
+
+/*
+ * WorstFit - the largest gap, when it fits. Ties go to the lowest address.
+ * Found at the end of the free gap index in O(log n).
+ */
+struct WorstFit
+{
+	static LinkedList::Slot find(LinkedList & list, Address size)
+	{
+		LinkedList::Slot slot = { -1, NULL, NULL, NULL };
+		if (list.freeGaps.empty() || list.freeGaps.rbegin()->first.first < size)
+			return slot;
+		std::map<std::pair<Address, Address>, Process *>::iterator worst =
+				list.freeGaps.lower_bound(std::make_pair(list.freeGaps.rbegin()->first.first, LLONG_MIN));
+		slot.firstByte = worst->first.second;
+		slot.previous = worst->second;
+		return slot;
+	}
+};
+
+/*
+ * FirstFit - the lowest address gap that fits. Walks the gaps from the start
+ * of memory and stops at the first one that fits.
+ */
+struct FirstFit
+{
+	static LinkedList::Slot find(LinkedList & list, Address size)
+	{
+		LinkedList::Slot slot = { -1, NULL, NULL, NULL };
+		Process * previous = NULL;
+		while (true)
+		{
+			Address first;
+			if (list.gapAfter(previous, first) >= size)
+			{
+				slot.firstByte = first;
+				slot.previous = previous;
+				return slot;
+			}
+			previous = list.after(previous);
+			if (previous == NULL)
+				return slot;
+		}
+	}
+};
+
+/*
+ * WalkBestFit - the same gap as BestFit, found by walking every process of the
+ * list instead of searching the gap index. Kept to measure the walk against the
+ * index and the extent table, it is not an RQ strategy.
+ */
+struct WalkBestFit
+{
+	static LinkedList::Slot find(LinkedList & list, Address size)
+	{
+		LinkedList::Slot slot = { -1, NULL, NULL, NULL };
+		Address best = LLONG_MAX;
+		Process * previous = NULL;
+		while (true)
+		{
+			Address first;
+			Address gap = list.gapAfter(previous, first);
+			if (gap >= size && gap < best)
+			{
+				best = gap;
+				slot.firstByte = first;
+				slot.previous = previous;
+			}
+			previous = list.after(previous);
+			if (previous == NULL)
+				return slot;
+		}
+	}
+};
+
+/*
+ * NextFit - like first fit, but the walk starts right after the last process
+ * allocated and wraps around to the start of memory.
+ */
+struct NextFit
+{
+	static LinkedList::Slot find(LinkedList & list, Address size)
+	{
+		LinkedList::Slot slot = { -1, NULL, NULL, NULL };
+		Process * previous = list.rover;
+		do
+		{
+			Address first;
+			if (list.gapAfter(previous, first) >= size)
+			{
+				slot.firstByte = first;
+				slot.previous = previous;
+				return slot;
+			}
+			//after the last process wrap around to the gap before the head
+			previous = list.after(previous);
+		}
+		while (previous != list.rover);
+		return slot;
+	}
+};
+
+//======================================================================
+/*
+ * BuddyZones class - binary buddy allocation for requests with strategy U.
+ * Zones of a power of two size are carved out of memory like any process and
+ * split into power of two blocks, from 16 bytes up to the whole zone. A request
+ * takes the smallest free block that fits, splitting a larger block in halves
+ * when needed. On release a block merges with its buddy, the other half of the
+ * block it was split from, as long as the buddy is free. Free blocks of every
+ * order are kept in sets, so split and coalesce take O(log n).
+ * A zone goes back to memory when its last process is released.
+ */
+class BuddyZones
+{
+private:
+	static const int smallestOrder = 4;   //16 bytes
+
+	//instance data
+	int zoneOrder;                         //zone size is 2 ^ zoneOrder bytes
+	std::vector<BuddyZone *> zones;        //zone of every id, NULL when the id is free
+	std::vector<int> freeIds;
+
+	//free blocks of every order as (zone id, offset in zone), lowest zone first
+	std::vector<std::set<std::pair<int, int> > > freeBlocks;
+
+	//index from process name id to the processes held in zones
+	std::unordered_map<int, std::vector<Process *> > byName;
+
+	//fragmentation and usage counters
+	long blockBytes;       //bytes of the blocks in use
+	long requestedBytes;   //bytes requested by the processes in those blocks
+	long fallbacks;        //requests larger than a zone, served by the gaps
+
+	/*
+	 * addFree - marks the block of the order at offset of zone as free
+	 */
+	void addFree(BuddyZone * zone, int offset, int order)
+	{
+		freeBlocks[order].insert(std::make_pair(zone->id, offset));
+		zone->freeBlocks[offset] = order;
+	}
+
+	/*
+	 * removeFree - marks the free block of the order at offset of zone as taken
+	 */
+	void removeFree(BuddyZone * zone, int offset, int order)
+	{
+		freeBlocks[order].erase(std::make_pair(zone->id, offset));
+		zone->freeBlocks.erase(offset);
+	}
+
+public:
+	/**
+	 * BuddyZones constructor - zones of zoneBytes, rounded down to a power of two of at least 4KB
+	 */
+	BuddyZones(int zoneBytes)
+	{
+		zoneOrder = 12;
+		while (zoneOrder < 30 && (1 << (zoneOrder + 1)) <= zoneBytes)
+			zoneOrder++;
+		freeBlocks.resize(zoneOrder + 1);
+		blockBytes = 0;
+		requestedBytes = 0;
+		fallbacks = 0;
+	}
+
+	/**
+	 * BuddyZones destructor - deallocates the zones. The processes they hold
+	 * belong to the process pool and the zone extents to the linked list.
+	 */
+	~BuddyZones()
+	{
+		for (std::size_t i = 0; i < zones.size(); i++)
+			delete zones[i];
+	}
+
+	/**
+	 * orderOf - returns the order of the smallest block that holds size bytes,
+	 * or -1 case size is larger than a zone
+	 */
+	int orderOf(Address size)
+	{
+		int order = smallestOrder;
+		while (order <= zoneOrder && (1 << order) < size)
+			order++;
+		return order <= zoneOrder ? order : -1;
+	}
+
+	/**
+	 * zoneBytes - bytes of memory reserved by each zone
+	 */
+	int zoneBytes()
+	{
+		return 1 << zoneOrder;
+	}
+
+	/**
+	 * fallback - counts a request larger than a zone, served by the gaps
+	 */
+	void fallback()
+	{
+		fallbacks++;
+	}
+
+	/**
+	 * findBlock - returns the zone holding the free block the next request of the
+	 * order takes, or NULL case no zone has room. offset is set to the block offset
+	 * in the zone. The block is the lowest one of the smallest order that fits.
+	 */
+	BuddyZone * findBlock(int order, int & offset)
+	{
+		for (int o = order; o <= zoneOrder; o++)
+			if (!freeBlocks[o].empty())
+			{
+				offset = freeBlocks[o].begin()->second;
+				return zones[freeBlocks[o].begin()->first];
+			}
+		return NULL;
+	}
+
+	/**
+	 * newZone - turns extent, a process of zoneBytes already in memory, into a
+	 * zone with a single free block
+	 */
+	BuddyZone * newZone(Process * extent)
+	{
+		BuddyZone * zone = new BuddyZone;
+		zone->extent = extent;
+		zone->order = zoneOrder;
+		if (freeIds.empty())
+		{
+			zone->id = (int) zones.size();
+			zones.push_back(zone);
+		}
+		else
+		{
+			zone->id = freeIds.back();
+			freeIds.pop_back();
+			zones[zone->id] = zone;
+		}
+		extent->zone = zone;
+		addFree(zone, 0, zoneOrder);
+		return zone;
+	}
+
+	/**
+	 * place - puts process p in the block findBlock returns, splitting larger blocks in halves
+	 */
+	void place(Process * p)
+	{
+		int order = orderOf(p->size);
+		int offset = 0;
+		BuddyZone * zone = findBlock(order, offset);
+		int blockOrder = zone->freeBlocks[offset];
+		removeFree(zone, offset, blockOrder);
+
+		//split down to the order, the upper halves stay free
+		while (blockOrder > order)
+		{
+			blockOrder--;
+			addFree(zone, offset + (1 << blockOrder), blockOrder);
+		}
+
+		zone->objects[offset] = p;
+		p->zone = zone;
+		p->firstByte = offset;
+		p->lastByte = offset + p->size - 1;
+		byName[p->name].push_back(p);
+		blockBytes += 1 << order;
+		requestedBytes += p->size;
+	}
+
+	/**
+	 * addressOf - returns the first byte in memory of p, a process held in a zone
+	 */
+	static Address addressOf(Process * p)
+	{
+		return p->zone->extent->firstByte + p->firstByte;
+	}
+
+	/**
+	 * findProcessByNumber - returns the lowest address process with the name
+	 * held in a zone, or NULL case there is none.
+	 */
+	Process * findProcessByNumber(int procNum)
+	{
+		std::unordered_map<int, std::vector<Process *> >::iterator match = byName.find(procNum);
+		if (match == byName.end())
+			return NULL;
+		Process * lowest = match->second[0];
+		for (std::size_t i = 1; i < match->second.size(); i++)
+			if (addressOf(match->second[i]) < addressOf(lowest))
+				lowest = match->second[i];
+		return lowest;
+	}
+
+	/**
+	 * remove - takes p, a process held in a zone, out of its block and merges
+	 * the block with its free buddies. Returns the zone extent case the zone is
+	 * now empty and must go back to memory, the zone itself is deallocated then.
+	 * Returns NULL otherwise.
+	 */
+	Process * remove(Process * p)
+	{
+		std::vector<Process *> & sameName = byName[p->name];
+		sameName.erase(std::find(sameName.begin(), sameName.end(), p));
+		if (sameName.empty())
+			byName.erase(p->name);
+
+		BuddyZone * zone = p->zone;
+		int order = orderOf(p->size);
+		int offset = (int) p->firstByte;
+		zone->objects.erase(offset);
+		blockBytes -= 1 << order;
+		requestedBytes -= p->size;
+
+		//merge with the buddy while it is free and of the same order
+		while (order < zoneOrder)
+		{
+			int buddy = offset ^ (1 << order);
+			std::map<int, int>::iterator free = zone->freeBlocks.find(buddy);
+			if (free == zone->freeBlocks.end() || free->second != order)
+				break;
+			removeFree(zone, buddy, order);
+			offset = offset < buddy ? offset : buddy;
+			order++;
+		}
+		addFree(zone, offset, order);
+
+		//case the zone is empty, give it back
+		if (order < zoneOrder)
+			return NULL;
+		removeFree(zone, 0, zoneOrder);
+		Process * extent = zone->extent;
+		extent->zone = NULL;
+		zones[zone->id] = NULL;
+		freeIds.push_back(zone->id);
+		delete zone;
+		return extent;
+	}
+
+	/**
+	 * toString - returns a line with the zone count and the internal fragmentation,
+	 * the share of the block bytes in use that no process requested
+	 */
+	std::string toString()
+	{
+		std::stringstream ss;
+		ss << "Buddy: " << (zones.size() - freeIds.size()) << " zones of " << zoneBytes() << " bytes, internal fragmentation "
+				<< (blockBytes > 0 ? 100.0 * (blockBytes - requestedBytes) / blockBytes : 0) << "% ("
+				<< (blockBytes - requestedBytes) << " of " << blockBytes << " block bytes unused, "
+				<< fallbacks << " fallbacks)\n";
+		return ss.str();
+	}
+};
+
+//======================================================================
+/*
+ *  Memory class- defines the instance data and methods needed to
+ * instantiate manipulate a linear chunk of memory
+ */
+class Memory
+{
+
+private:
+	//processes and their names, declared first so it outlives everything holding processes
+	ProcessPool pool;
+	LinkedList processes;
+	Address max;
+
+	//real arena backing the memory, NULL when addresses are only simulated
+	char * arena;
+	std::size_t arenaSize;
+
+	//handle table, each handle resolves to the process it was given to
+	std::vector<Process *> handles;
+	std::vector<int> freeHandles;
+
+	//front end for small requests, used only when enabled
+	SizeClasses sizeClasses;
+	bool sizeClassesEnabled;
+
+	//buddy allocation for requests with strategy U, NULL when not enabled
+	BuddyZones * buddy;
+
+	/*
+	 * Shard - part of the address space with its own memory and lock
+	 */
+	struct Shard
+	{
+		Memory * memory;     //processes in the shard, addresses relative to base
+		Address base;        //first byte of the shard
+		std::mutex lock;
+	};
+
+	//shards of the address space, empty when the memory is not split
+	std::vector<Shard *> shards;
+	std::atomic<long> stolen;   //requests placed outside their home shard
+
+	//requests served, requests with no room and releases since the start
+	long allocations;
+	std::atomic<long> failedAllocations;
+	long releases;
+
+	//resizes served and those served without moving the process
+	long resizes;
+	long resizesInPlace;
+
+	//name of every wire id seen by applyBatch, -1 for ids not seen yet
+	std::vector<int> wireNames;
+
+	/*
+	 * BackgroundCompaction - compaction built by a worker thread off to the side.
+	 * The worker reads only the copies of the first byte, size, name and handle
+	 * of every process of order and the old arena. It makes a new record for each
+	 * of them in records, laid out side by side in a list of its own with its gap,
+	 * name and address indexes, and a handle table for them, and copies the bytes
+	 * to the new arena. Everything else stays with the command thread. Records
+	 * released while it runs are retired by the pool, so order stays valid until
+	 * the publish.
+	 */
+	struct BackgroundCompaction
+	{
+		std::thread worker;
+		std::atomic<bool> done;
+		std::vector<Process *> order;       //processes of the list when it started, address order
+		std::vector<Process *> arrivals;    //processes added to the list since
+		std::vector<Address> from;          //first byte, size, name and handle of every process of order
+		std::vector<Address> sizes;
+		std::vector<int> names;
+		std::vector<int> handleIds;
+		std::vector<std::size_t> extents;   //positions in order of the slab and zone extents
+		Address max;
+		ProcessPool * pool;                 //pool the new records join at the publish, not touched by the worker
+		Process * records;                  //new record of every process of order, made by the worker
+		LinkedList * layout;                //list of the new records, the old list once published
+		std::vector<Process *> handles;     //handle table of the new records, as large as the old one when it started
+		const char * source;                //old and new arena, NULL when addresses are only simulated
+		char * target;
+		long bytesMoved;
+		int regionsMoved;
+		std::chrono::steady_clock::time_point start;
+	};
+
+	//compaction in flight, NULL when none is
+	BackgroundCompaction * background;
+
+	/*
+	 * buildLayout - worker of a background compaction. Slides the processes of
+	 * job down like compactProcesses, into new records and a new list, and with
+	 * an arena copies their bytes to the new arena. Commands do not write process
+	 * bytes, so the copy stays current while they run.
+	 */
+	static void buildLayout(BackgroundCompaction * job)
+	{
+		std::size_t count = job->from.size();
+		if (count > 0)
+			job->records = (Process *) ::operator new(sizeof(Process) * count);
+		job->layout = new LinkedList(job->max, job->pool);
+		for (std::size_t i = 0; i < count; i++)
+		{
+			Process * p = new (job->records + i) Process(job->names[i], job->sizes[i]);
+			p->handle = job->handleIds[i];
+			if (p->handle >= 0)
+				job->handles[p->handle] = p;
+			job->layout->appendPacked(p);
+			if (job->target != NULL)
+				memcpy(job->target + p->firstByte, job->source + job->from[i], job->sizes[i]);
+			if (job->from[i] != p->firstByte)
+			{
+				job->bytesMoved += job->sizes[i];
+				job->regionsMoved++;
+			}
+		}
+		job->done.store(true, std::memory_order_release);
+	}
+
+	/*
+	 * discardLayout - deallocates the indexes of a list whose records went back
+	 * to the pool, run on a thread of its own so commands do not wait for it
+	 */
+	static void discardLayout(LinkedList * layout)
+	{
+		delete layout;
+	}
+
+	/*
+	 * placeInList - adds p to the process list in slot, noting it case a
+	 * background compaction has to move it at the publish
+	 */
+	void placeInList(Process * p, LinkedList::Slot slot)
+	{
+		processes.addProcessToList(p, slot);
+		if (background != NULL)
+			background->arrivals.push_back(p);
+	}
+
+	/*
+	 * slabToCarve, zoneToCarve - markers findMemorySlot sets as the slab or zone of
+	 * a slot case the size class or the buddy zones have no room. The slot then
+	 * names the gap the new slab or zone takes, addProcessToMemory carves it.
+	 */
+	static Slab * slabToCarve()
+	{
+		static Slab marker;
+		return &marker;
+	}
+
+	static BuddyZone * zoneToCarve()
+	{
+		static BuddyZone marker;
+		return &marker;
+	}
+
+	/*
+	 * addressOf - returns the first byte in memory of p, also when it is held in a slab or a buddy zone
+	 */
+	Address addressOf(Process * p)
+	{
+		if (p->slab != NULL && p->slab->extent != p)
+			return SizeClasses::addressOf(p);
+		if (p->zone != NULL && p->zone->extent != p)
+			return BuddyZones::addressOf(p);
+		return p->firstByte;
+	}
+
+	//disable copies, the arena is owned by one memory
+	Memory(const Memory &);
+	Memory & operator=(const Memory &);
+
+public:
+
+	/*
+	 * Metrics - health of the memory, read in O(1) from what the list keeps up
+	 * to date on every change. Slabs and buddy zones count as one region each.
+	 * Fragmentation is the share of the free bytes outside the largest free block.
+	 */
+	struct Metrics
+	{
+		Address usedBytes;
+		Address freeBytes;
+		long regions;
+		long gaps;
+		Address largestFree;
+		double fragmentation;
+		long allocations;
+		long failedAllocations;
+		long releases;
+		long resizes;
+		long resizesInPlace;
+	};
+
+	/*
+	 * CompactionSwap - what publishing a background compaction did. slid is true
+	 * case the processes added meanwhile did not fit after the compacted ones and
+	 * memory was slid in place instead. pauseSeconds is how long commands waited
+	 * for the swap, buildSeconds how long the worker ran next to them.
+	 */
+	struct CompactionSwap
+	{
+		long bytesMoved;
+		int regionsMoved;
+		int arrivals;
+		bool slid;
+		double pauseSeconds;
+		double buildSeconds;
+	};
+
+	/*
+	 * Memory constructor - defined the number of available bytes to be allocated.
+	 * Note the value - 1 is passed into constructor to account for the max - 1
+	 * memory requirement.
+	 * Case backed is true, a real arena of m + 1 bytes is reserved with mmap and
+	 * huge pages are requested for it where the system supports them. If the arena
+	 * can not be reserved, addresses are only simulated. The arena only reserves
+	 * address space, pages are backed as the processes touch them.
+	 */
+	Memory(Address m, bool backed = false) : processes(m, &pool)
+{
+		max = m;
+		arena = NULL;
+		arenaSize = 0;
+		sizeClassesEnabled = false;
+		buddy = NULL;
+		stolen.store(0);
+		allocations = 0;
+		failedAllocations.store(0);
+		releases = 0;
+		resizes = 0;
+		resizesInPlace = 0;
+		background = NULL;
+		if (backed)
+		{
+			arenaSize = (std::size_t) m + 1;
+			void * reserved = mmap(NULL, arenaSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+			if (reserved == MAP_FAILED)
+				arenaSize = 0;
+			else
+			{
+				arena = (char *) reserved;
+#ifdef MADV_HUGEPAGE
+				madvise(arena, arenaSize, MADV_HUGEPAGE);
+#endif
+			}
+		}
+}
+
+	/*
+	 * Memory destructor - releases the arena, if any
+	 */
+	~Memory()
+	{
+		if (background != NULL)
+		{
+			background->worker.join();
+			if (background->target != NULL)
+				munmap(background->target, arenaSize);
+			delete background->layout;
+			::operator delete(background->records);
+			delete background;
+		}
+		if (arena != NULL)
+			munmap(arena, arenaSize);
+		delete buddy;
+		for (std::size_t k = 0; k < shards.size(); k++)
+		{
+			delete shards[k]->memory;
+			delete shards[k];
+		}
+	}
+
+	/**
+	 * findMemorySlot - Finds available memory for required
+	 * size using the placement policy, best fit by default. Calls the linked list method
+	 * that seeks the best place for the process with required size.
+	 * Returns a handle to the slot, its first byte is -1 if there is no room.
+	 */ 
+	template <class Policy = BestFit>
+	LinkedList::Slot findMemorySlot(Address sizeRequired)
+	{
+		return processes.findSpotInList<Policy>(sizeRequired);
+	}
+
+	/**
+	 * findMemorySlot - Finds available memory for required size using the
+	 * strategy letter of the RQ command: B best fit, F first fit, N next fit,
+	 * W worst fit or U buddy, when enabled. Returns a handle to the slot, its first byte is -1 if there is no room.
+	 */
+	LinkedList::Slot findMemorySlot(Address sizeRequired, char strategy)
+	{
+		//case a buddy request, the gap for a new zone when no zone has room. Larger requests use the gaps.
+		if (strategy == 'U' && buddy != NULL)
+		{
+			int order = buddy->orderOf(sizeRequired);
+			if (order >= 0)
+			{
+				int offset = 0;
+				BuddyZone * zone = buddy->findBlock(order, offset);
+				if (zone == NULL)
+				{
+					LinkedList::Slot place = findMemorySlot<BestFit>(buddy->zoneBytes());
+					if (place.firstByte == -1)
+						failedAllocations++;
+					else
+						place.zone = zoneToCarve();
+					return place;
+				}
+				LinkedList::Slot slot = { zone->extent->firstByte + offset, NULL, NULL, zone };
+				return slot;
+			}
+			buddy->fallback();
+		}
+
+		//case small requests go to the size classes, the gap for a new slab when the class has no room
+		int sizeClass = sizeClassesEnabled ? SizeClasses::classOf(sizeRequired) : -1;
+		if (sizeClass >= 0)
+		{
+			Slab * slab = sizeClasses.slabWithRoom(sizeClass);
+			if (slab != NULL)
+			{
+				LinkedList::Slot slot = { SizeClasses::nextAddress(slab), NULL, slab, NULL };
+				return slot;
+			}
+			LinkedList::Slot place = findMemorySlot<BestFit>(SizeClasses::extentBytes());
+			if (place.firstByte != -1)
+			{
+				place.slab = slabToCarve();
+				return place;
+			}
+		}
+
+		LinkedList::Slot slot;
+		switch (strategy)
+		{
+		case 'F':
+			slot = findMemorySlot<FirstFit>(sizeRequired);
+			break;
+		case 'N':
+			slot = findMemorySlot<NextFit>(sizeRequired);
+			break;
+		case 'W':
+			slot = findMemorySlot<WorstFit>(sizeRequired);
+			break;
+		default:
+			slot = findMemorySlot<BestFit>(sizeRequired);
+			break;
+		}
+		if (slot.firstByte == -1)
+			failedAllocations++;
+		return slot;
+	}
+
+	/**
+	 * isStrategy - returns true case the letter names a placement strategy: B, F, N, W or U
+	 */
+	static bool isStrategy(std::string_view letter)
+	{
+		return letter == "B" || letter == "F" || letter == "N" || letter == "W" || letter == "U";
+	}
+
+
+	/**
+	 * write - writes the status of the bytes in [from : to] to out, the
+	 * information specified in the assignment, or JSON lines case json is true.
+	 * Lines go straight to out, nothing is built in memory first. Addresses are
+	 * written plus base. A memory split in shards writes every shard holding
+	 * bytes in the range.
+	 */
+	void write(std::ostream & out, Address from, Address to, bool json, Address base = 0)
+	{
+		if (!shards.empty())
+		{
+			for (std::size_t k = 0; k < shards.size(); k++)
+				if (shards[k]->base <= to && shards[k]->base + shards[k]->memory->max >= from)
+					writeShard(out, k, from, to, json);
+			if (!json)
+				out << "Requests placed outside their home shard: " << stolen.load() << "\n\n";
+			return;
+		}
+		processes.write(out, max, base, from - base, to - base, json);
+		if (!json && (sizeClassesEnabled || buddy != NULL))
+			out << sizeClassesToString() << "\n";
+	}
+
+	/**
+	 * writeShard - writes the status of the bytes in [from : to] of shard k,
+	 * with the shard range first
+	 */
+	void writeShard(std::ostream & out, std::size_t k, Address from, Address to, bool json)
+	{
+		Shard * shard = shards[k];
+		std::lock_guard<std::mutex> guard(shard->lock);
+		if (json)
+		{
+			writeExtent(out, shard->base, shard->base + shard->memory->max, 0, true);
+			out << ",\"type\":\"shard\",\"shard\":" << k << "}\n";
+		}
+		else
+		{
+			char buffer[50];
+			int width = addressWidth(max);
+			snprintf(buffer, sizeof(buffer), "%*lld : %*lld", width, shard->base, width, shard->base + shard->memory->max);
+			out << "\nShard " << k << " [ " << buffer << " ]\n";
+		}
+		shard->memory->write(out, from, to, json, shard->base);
+	}
+
+	/**
+	 * addProcessAt - adds a process with the name and size at first, the way
+	 * the write-ahead log recorded it. Returns false case those bytes are not free.
+	 */
+	bool addProcessAt(std::string_view name, Address size, Address first)
+	{
+		LinkedList::Slot slot = processes.slotAt(first, size);
+		if (slot.firstByte == -1)
+			return false;
+		addProcessToMemory(newProcess(name, size), slot);
+		return true;
+	}
+
+	/**
+	 * newProcess - returns a new process with the name and size, made by the
+	 * process pool of the memory. It must be added with addProcessToMemory.
+	 */
+	Process * newProcess(std::string_view name, Address size)
+	{
+		return pool.create(name, size);
+	}
+
+	/**
+	 * addProcessToMemory - adds a process in the slot specified by place
+	 * parameter. Used after findMemorySlot returns the best fit slot
+	 * for the process.
+	 * Case the memory is backed by an arena, returns the handle that resolves
+	 * to the process bytes, which stays valid across compactions. Returns -1 otherwise.
+	 */ 
+	int addProcessToMemory(Process * p, LinkedList::Slot place)
+	{
+		//case the slot names the gap of a new slab or zone, carve it first, the process takes its first bytes
+		LinkedList::Slot extentPlace = { place.firstByte, place.previous, NULL, NULL };
+		if (place.slab == slabToCarve())
+		{
+			int sizeClass = SizeClasses::classOf(p->size);
+			Process * extent = pool.create("slab " + std::to_string(sizeClass), SizeClasses::extentBytes());
+			placeInList(extent, extentPlace);
+			place.slab = sizeClasses.newSlab(sizeClass, extent);
+		}
+		else if (place.zone == zoneToCarve())
+		{
+			Process * extent = pool.create("buddy zone", buddy->zoneBytes());
+			placeInList(extent, extentPlace);
+			place.zone = buddy->newZone(extent);
+		}
+
+		if (place.slab != NULL)
+			sizeClasses.place(p, place.slab);
+		else if (place.zone != NULL)
+			buddy->place(p);
+		else
+		{
+			//case a small request the size classes had no room for
+			if (sizeClassesEnabled && SizeClasses::classOf(p->size) >= 0)
+				sizeClasses.fallback();
+			placeInList(p, place);
+		}
+		allocations++;
+		if (arena == NULL)
+			return -1;
+
+		//reuse a released handle before growing the table
+		if (freeHandles.empty())
+		{
+			p->handle = (int) handles.size();
+			handles.push_back(p);
+		}
+		else
+		{
+			p->handle = freeHandles.back();
+			freeHandles.pop_back();
+			handles[p->handle] = p;
+		}
+		return p->handle;
 	}
 
 	/**
@@ -462,184 +2643,3670 @@ public:
 	 * exists, it is removed and true is returned, else the process does not exist
 	 * and then false is returned and no removal is done. Case processes have the same
 	 * name, only the first match starting from low memory is removed.
+	 * The handle of the process, if any, is released.
+	 */ 
+	bool removeProcessFromMemory(std::string_view procName)
+	{
+		//case the memory is split, shards are in address order, so the first match is the lowest
+		if (!shards.empty())
+		{
+			for (std::size_t k = 0; k < shards.size(); k++)
+			{
+				std::lock_guard<std::mutex> guard(shards[k]->lock);
+				if (shards[k]->memory->removeProcessFromMemory(procName))
+					return true;
+			}
+			return false;
+		}
+
+		//case no process has the name, it has no id
+		int name = pool.find(procName);
+		if (name < 0)
+			return false;
+		return removeProcessFromMemory(name);
+	}
+
+	/**
+	 * removeProcessFromMemory - removes the lowest address process with the name
+	 * of id, in a memory that is not split. Returns false case no process has it.
+	 */
+	bool removeProcessFromMemory(int name)
+	{
+		//lowest address match, in the list, in a slab or in a buddy zone
+		Process * p = processes.findProcessByNumber(name);
+		Process * small = sizeClassesEnabled ? sizeClasses.findProcessByNumber(name) : NULL;
+		Process * block = (buddy != NULL) ? buddy->findProcessByNumber(name) : NULL;
+		if (small != NULL && (p == NULL || addressOf(small) < addressOf(p)))
+			p = small;
+		if (block != NULL && (p == NULL || addressOf(block) < addressOf(p)))
+			p = block;
+		if (p == NULL)
+			return false;
+		if (p->handle >= 0)
+		{
+			handles[p->handle] = NULL;
+			freeHandles.push_back(p->handle);
+		}
+
+		//case the process is in a slab or a zone, an empty slab or zone goes back to memory
+		if (p == small || p == block)
+		{
+			Process * extent = (p == small) ? sizeClasses.remove(p) : buddy->remove(p);
+			if (extent != NULL)
+				processes.removeProcess(extent, true);
+			pool.destroy(p);
+		}
+		else
+			processes.removeProcess(p, true);
+		releases++;
+		return true;
+	}
+
+	/**
+	 * resizeProcess - resizes the lowest address process with the name to size
+	 * bytes. It stays in place case it shrinks or the free gap right after it is
+	 * large enough, otherwise it moves to the best fit gap, searched with its own
+	 * bytes free. Case the memory is backed by an arena the bytes kept move with
+	 * it, its handle stays valid. Returns the first byte of the process and sets
+	 * inPlace, or -1 case no process has the name, -2 case there is no room, the
+	 * process is left as it was, and -3 case it is held in a slab or a buddy zone.
+	 */
+	Address resizeProcess(std::string_view procName, Address size, bool & inPlace)
+	{
+		//case the memory is split, shards are in address order, so the first match is the lowest
+		if (!shards.empty())
+		{
+			for (std::size_t k = 0; k < shards.size(); k++)
+			{
+				std::lock_guard<std::mutex> guard(shards[k]->lock);
+				Address first = shards[k]->memory->resizeProcess(procName, size, inPlace);
+				if (first != -1)
+					return first < 0 ? first : shards[k]->base + first;
+			}
+			return -1;
+		}
+
+		int name = pool.find(procName);
+		if (name < 0)
+			return -1;
+		Process * p = processes.findProcessByNumber(name);
+		Process * small = sizeClassesEnabled ? sizeClasses.findProcessByNumber(name) : NULL;
+		Process * block = (buddy != NULL) ? buddy->findProcessByNumber(name) : NULL;
+		if ((small != NULL && (p == NULL || addressOf(small) < addressOf(p))) || (block != NULL && (p == NULL || addressOf(block) < addressOf(p))))
+			return -3;
+		if (p == NULL)
+			return -1;
+
+		//case the process shrinks or the gap after it has room
+		inPlace = processes.resizeInPlace(p, size);
+		if (inPlace)
+		{
+			resizes++;
+			resizesInPlace++;
+			return p->firstByte;
+		}
+
+		//otherwise move it through best fit, back to its place case no gap has room
+		Address from = p->firstByte;
+		Address oldSize = p->size;
+		processes.removeProcess(p, false);
+		LinkedList::Slot slot = findMemorySlot<BestFit>(size);
+		if (slot.firstByte == -1)
+		{
+			processes.addProcessToList(p, processes.slotAt(from, oldSize));
+			failedAllocations++;
+			return -2;
+		}
+		p->size = size;
+		placeInList(p, slot);
+		if (arena != NULL)
+			memmove(arena + p->firstByte, arena + from, std::min(oldSize, size));
+		resizes++;
+		return p->firstByte;
+	}
+
+	/**
+	 * applyBatch - applies the count operations of a binary batch in one pass and
+	 * writes their results, see WireOp. A new wire id is named by its digits once
+	 * and keeps the name. Operations are not valid in a split memory.
+	 */
+	void applyBatch(const WireOp * ops, int count, Address * results)
+	{
+		for (int i = 0; i < count; i++)
+		{
+			const WireOp & op = ops[i];
+			results[i] = -2;
+			if (!shards.empty() || op.id < 0 || op.id >= wireIds)
+				continue;
+			if (op.id >= (int) wireNames.size())
+				wireNames.resize(std::max((std::size_t) op.id + 1, wireNames.size() * 2), -1);
+			if (wireNames[op.id] < 0)
+				wireNames[op.id] = pool.intern(std::to_string(op.id));
+
+			//case a request, the same checks as RQ
+			if (op.op == 'R')
+			{
+				if (op.size <= 0 || !isStrategy(std::string_view(&op.strategy, 1)) || (op.strategy == 'U' && buddy == NULL))
+					continue;
+				LinkedList::Slot slot = findMemorySlot(op.size, op.strategy);
+				if (slot.firstByte != -1)
+					addProcessToMemory(pool.create(wireNames[op.id], op.size), slot);
+				results[i] = slot.firstByte;
+			}
+			else if (op.op == 'L')
+				results[i] = removeProcessFromMemory(wireNames[op.id]) ? 0 : -1;
+		}
+	}
+
+	/**
+	 * wireName - returns the name applyBatch gave to the wire id
+	 */
+	const std::string & wireName(int id)
+	{
+		return pool.names().nameOf(wireNames[id]);
+	}
+
+	/**
+	 * removeProcessFromMemory - removes p, a process added with addProcessToMemory
+	 * outside of any slab or buddy zone. Used by callers that keep the process.
+	 */
+	void removeProcessFromMemory(Process * p)
+	{
+		if (p->handle >= 0)
+		{
+			handles[p->handle] = NULL;
+			freeHandles.push_back(p->handle);
+		}
+		processes.removeProcess(p, true);
+		releases++;
+	}
+
+	/**
+	 * enableSizeClasses - serves small requests from the size classes from now on
+	 */
+	void enableSizeClasses()
+	{
+		sizeClassesEnabled = true;
+		for (std::size_t k = 0; k < shards.size(); k++)
+			shards[k]->memory->enableSizeClasses();
+	}
+
+	/**
+	 * enableBuddy - serves requests with strategy U from buddy zones of zoneBytes from now on
+	 */
+	void enableBuddy(int zoneBytes)
+	{
+		if (buddy == NULL)
+			buddy = new BuddyZones(zoneBytes);
+		for (std::size_t k = 0; k < shards.size(); k++)
+			shards[k]->memory->enableBuddy(zoneBytes);
+	}
+
+	/**
+	 * enableShards - splits the address space in count shards of about the same
+	 * size, each with its own process list, free gap index and lock. Must be
+	 * called before any process is added and before the size classes or buddy
+	 * zones are enabled.
+	 */
+	void enableShards(int count)
+	{
+		Address length = (max + 1) / count;
+		for (int k = 0; k < count; k++)
+		{
+			Shard * shard = new Shard();
+			shard->base = k * length;
+			Address last = (k == count - 1) ? max : shard->base + length - 1;
+			shard->memory = new Memory(last - shard->base);
+			shards.push_back(shard);
+		}
+	}
+
+	/**
+	 * isSharded - returns true case the address space is split in shards
+	 */
+	bool isSharded()
+	{
+		return !shards.empty();
+	}
+
+	/**
+	 * shardCount - returns the number of shards, 0 case the memory is not split
+	 */
+	std::size_t shardCount()
+	{
+		return shards.size();
+	}
+
+	/**
+	 * addProcessToShards - places a process with the name and size, using the strategy letter, in the home shard
+	 * picked by hint, such as a thread id or a hash of the name, or case the home
+	 * shard is full in the next shard with room. Only one shard is locked at a
+	 * time, so work in the other shards is not blocked.
+	 * Returns false case no shard has room.
+	 */
+	bool addProcessToShards(std::string_view name, Address size, char strategy, std::size_t hint)
+	{
+		std::size_t home = hint % shards.size();
+		for (std::size_t i = 0; i < shards.size(); i++)
+		{
+			Shard * shard = shards[(home + i) % shards.size()];
+			std::lock_guard<std::mutex> guard(shard->lock);
+			LinkedList::Slot slot = shard->memory->findMemorySlot(size, strategy);
+			if (slot.firstByte != -1)
+			{
+				shard->memory->addProcessToMemory(shard->memory->newProcess(name, size), slot);
+				if (i > 0)
+					stolen++;
+				return true;
+			}
+		}
+		failedAllocations++;
+		return false;
+	}
+
+	/**
+	 * metrics - returns the bytes used and free, the regions and free gaps, the
+	 * largest free block, the external fragmentation and the request counters.
+	 * Nothing is walked, so it costs the same for any number of processes.
+	 * Case the memory is split, the shards are added up.
+	 */
+	Metrics metrics()
+	{
+		Metrics total = { 0, 0, 0, 0, 0, 0, allocations, failedAllocations.load(), releases, resizes, resizesInPlace };
+		if (shards.empty())
+		{
+			total.usedBytes = processes.usedBytes();
+			total.freeBytes = max + 1 - total.usedBytes;
+			total.regions = processes.regionCount();
+			total.gaps = processes.gapCount();
+			total.largestFree = processes.largestGap();
+		}
+		for (std::size_t k = 0; k < shards.size(); k++)
+		{
+			std::lock_guard<std::mutex> guard(shards[k]->lock);
+			Metrics shard = shards[k]->memory->metrics();
+			total.usedBytes += shard.usedBytes;
+			total.freeBytes += shard.freeBytes;
+			total.regions += shard.regions;
+			total.gaps += shard.gaps;
+			total.largestFree = std::max(total.largestFree, shard.largestFree);
+			total.allocations += shard.allocations;
+			total.releases += shard.releases;
+			total.resizes += shard.resizes;
+			total.resizesInPlace += shard.resizesInPlace;
+		}
+		if (total.freeBytes > 0)
+			total.fragmentation = 1 - (double) total.largestFree / total.freeBytes;
+		return total;
+	}
+
+	/**
+	 * save - writes the processes of the memory and their names to file in the
+	 * snapshot format, covering sequence commands of the write-ahead log. Only a
+	 * memory with no slabs, buddy zones or shards can be saved. Returns false
+	 * case the memory can not be saved or writing fails.
+	 */
+	bool save(const std::string & file, Address sequence = 0)
+	{
+		if (sizeClassesEnabled || buddy != NULL || !shards.empty())
+			return false;
+		std::ofstream out(file.c_str(), std::ios::binary | std::ios::trunc);
+		return out && processes.save(out, max, sequence);
+	}
+
+	/**
+	 * load - adds the processes saved in file by save to the empty memory. The
+	 * file is mapped and its regions and names are read in place, with no
+	 * parsing. sequence is set to the log commands the snapshot covers.
+	 * Returns false case the file can not be read, is not a snapshot of
+	 * this version, or its processes do not fit in the memory.
+	 */
+	bool load(const std::string & file, Address & sequence)
+	{
+		if (!shards.empty() || processes.regionCount() > 0)
+			return false;
+		int fd = open(file.c_str(), O_RDONLY);
+		if (fd < 0)
+			return false;
+		off_t length = lseek(fd, 0, SEEK_END);
+		void * mapped = (length >= (off_t) sizeof(SnapshotHeader)) ? mmap(NULL, length, PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+		close(fd);
+		if (mapped == MAP_FAILED)
+			return false;
+
+		//the header must match this version and account for every byte of the file, each count is bounded first so the sum does not overflow
+		const char * bytes = (const char *) mapped;
+		const SnapshotHeader * header = (const SnapshotHeader *) bytes;
+		Address size = (Address) length - (Address) sizeof(SnapshotHeader);
+		bool valid = memcmp(header->magic, snapshotMagic, sizeof(snapshotMagic)) == 0
+				&& header->version == snapshotVersion && header->regionBytes == (int) sizeof(SnapshotRegion)
+				&& header->regions >= 0 && header->names >= 0 && header->nameBytes >= 0
+				&& header->regions <= size / (Address) sizeof(SnapshotRegion)
+				&& header->names < size / (Address) sizeof(Address) && header->nameBytes <= size
+				&& header->regions * (Address) sizeof(SnapshotRegion) + (header->names + 1) * (Address) sizeof(Address) + header->nameBytes == size;
+		const SnapshotRegion * regions = (const SnapshotRegion *) (bytes + sizeof(SnapshotHeader));
+		const Address * offsets = (const Address *) (regions + (valid ? header->regions : 0));
+		const char * names = (const char *) (offsets + (valid ? header->names + 1 : 0));
+		for (Address i = 0; valid && i < header->names; i++)
+			valid = offsets[0] == 0 && offsets[i] <= offsets[i + 1] && offsets[i + 1] <= header->nameBytes;
+
+		//every name is interned once, processes take its id
+		std::vector<int> ids;
+		if (valid)
+		{
+			pool.reserve(header->names);
+			ids.reserve(header->names);
+			for (Address i = 0; i < header->names; i++)
+				ids.push_back(pool.intern(std::string_view(names + offsets[i], offsets[i + 1] - offsets[i])));
+		}
+
+		//processes must be in address order, not overlap and fit in the memory
+		std::vector<Process *> order;
+		order.reserve(valid ? header->regions : 0);
+		Address nextFirst = 0;
+		for (Address i = 0; valid && i < header->regions; i++)
+		{
+			const SnapshotRegion & region = regions[i];
+			valid = region.firstByte >= nextFirst && region.size > 0 && region.size <= max - region.firstByte + 1
+					&& region.name >= 0 && region.name < header->names;
+			if (valid)
+			{
+				Process * p = pool.create(ids[region.name], region.size);
+				p->firstByte = region.firstByte;
+				order.push_back(p);
+				nextFirst = region.firstByte + region.size;
+			}
+		}
+		if (valid)
+			sequence = header->sequence;
+		munmap(mapped, length);
+		for (std::size_t i = 0; i < ids.size(); i++)
+			pool.release(ids[i]);
+		if (!valid)
+		{
+			for (std::size_t i = 0; i < order.size(); i++)
+				pool.destroy(order[i]);
+			return false;
+		}
+		processes.load(order, ids.size());
+		return true;
+	}
+
+	/**
+	 * isBuddyEnabled - returns true case requests with strategy U can be served
+	 */
+	bool isBuddyEnabled()
+	{
+		return buddy != NULL;
+	}
+
+	/**
+	 * sizeClassesToString - returns the slab count and hit rate line and the
+	 * buddy fragmentation line, each one only case it is enabled
+	 */
+	std::string sizeClassesToString()
+	{
+		return (sizeClassesEnabled ? sizeClasses.toString() : "") + (buddy != NULL ? buddy->toString() : "");
+	}
+
+	/*
+	 * compactMemory - compacts the linear memory as defined in LinkedList class.
+	 * Moves processes towards low end of bytes and frees up space towards
+	 * the high bytes in memory. A method to a method is used ofr encapsulation.
+	 * Case the memory is backed by an arena, the process bytes are moved too.
+	 * Returns the number of bytes moved.
+	 */
+	long compactMemory(Address lastByte)
+	{
+		//case the memory is split, every shard compacts on its own
+		if (!shards.empty())
+		{
+			long moved = 0;
+			for (std::size_t k = 0; k < shards.size(); k++)
+				moved += compactShard(k);
+			return moved;
+		}
+		return processes.compactProcesses(lastByte, arena);
+	}
+
+	/*
+	 * compactShard - compacts shard k towards its low bytes, holding only its
+	 * lock. Returns the number of bytes moved.
+	 */
+	long compactShard(std::size_t k)
+	{
+		std::lock_guard<std::mutex> guard(shards[k]->lock);
+		return shards[k]->memory->compactMemory(shards[k]->memory->max);
+	}
+
+	/*
+	 * compactMemoryPlanned - compacts the linear memory moving as few bytes as
+	 * possible, as defined in LinkedList class. Case the memory is backed by an
+	 * arena, the process bytes are moved too. Returns the bytes and processes moved,
+	 * next to what compactMemory would have moved.
+	 */
+	LinkedList::CompactionReport compactMemoryPlanned()
+	{
+		if (!shards.empty())
+		{
+			LinkedList::CompactionReport total = { 0, 0, 0, 0 };
+			for (std::size_t k = 0; k < shards.size(); k++)
+			{
+				std::lock_guard<std::mutex> guard(shards[k]->lock);
+				LinkedList::CompactionReport report = shards[k]->memory->compactMemoryPlanned();
+				total.bytesMoved += report.bytesMoved;
+				total.regionsMoved += report.regionsMoved;
+				total.slideBytes += report.slideBytes;
+				total.slideRegions += report.slideRegions;
+			}
+			return total;
+		}
+		return processes.compactPlanned(arena);
+	}
+
+	/*
+	 * compactMemoryStep - runs one step of incremental compaction as defined in
+	 * LinkedList class, moving about budget bytes. Case the memory is backed by an
+	 * arena, the process bytes are moved too. Returns the number of bytes moved,
+	 * regions is set to the number of processes moved.
+	 */
+	long compactMemoryStep(long budget, int & regions)
+	{
+		//case the memory is split, the budget goes to the shards in order until it is spent
+		if (!shards.empty())
+		{
+			long moved = 0;
+			regions = 0;
+			for (std::size_t k = 0; k < shards.size() && moved < budget; k++)
+			{
+				std::lock_guard<std::mutex> guard(shards[k]->lock);
+				if (shards[k]->memory->isCompacted())
+					continue;
+				int shardRegions = 0;
+				moved += shards[k]->memory->compactMemoryStep(budget - moved, shardRegions);
+				regions += shardRegions;
+			}
+			return moved;
+		}
+		return processes.compactStep(budget, arena, regions);
+	}
+
+	/**
+	 * startBackgroundCompaction - starts compacting the memory like compactMemory
+	 * on a worker thread. Commands keep working on the current layout until
+	 * publishCompaction swaps in the compacted one. Case the memory is backed by an
+	 * arena, the worker copies the bytes to a new arena. Returns false case a
+	 * compaction is in flight, the memory is split or the new arena can not be reserved.
+	 */
+	bool startBackgroundCompaction()
+	{
+		if (background != NULL || !shards.empty())
+			return false;
+		char * target = NULL;
+		if (arena != NULL)
+		{
+			void * reserved = mmap(NULL, arenaSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+			if (reserved == MAP_FAILED)
+				return false;
+			target = (char *) reserved;
+#ifdef MADV_HUGEPAGE
+			madvise(target, arenaSize, MADV_HUGEPAGE);
+#endif
+		}
+
+		background = new BackgroundCompaction();
+		background->done.store(false);
+		background->max = max;
+		background->pool = &pool;
+		background->records = NULL;
+		background->layout = NULL;
+		background->source = arena;
+		background->target = target;
+		background->bytesMoved = 0;
+		background->regionsMoved = 0;
+		background->start = std::chrono::steady_clock::now();
+		processes.collect(background->order);
+		std::size_t count = background->order.size();
+		background->from.resize(count);
+		background->sizes.resize(count);
+		background->names.resize(count);
+		background->handleIds.resize(count);
+		background->handles.assign(handles.size(), NULL);
+		for (std::size_t i = 0; i < count; i++)
+		{
+			Process * p = background->order[i];
+			background->from[i] = p->firstByte;
+			background->sizes[i] = p->size;
+			background->names[i] = p->name;
+			background->handleIds[i] = p->handle;
+			if (p->slab != NULL || p->zone != NULL)
+				background->extents.push_back(i);
+		}
+		pool.hold();
+		background->worker = std::thread(buildLayout, background);
+		return true;
+	}
+
+	/**
+	 * publishCompaction - swaps in the layout of the background compaction case the
+	 * worker is done, or waits for it case wait is true, and reports the swap. The
+	 * records released meanwhile leave the new list, so their gaps stay free, and
+	 * the processes added meanwhile move right after the compacted ones. Then the
+	 * lists, the handle tables and the arenas are exchanged, the work left is in
+	 * the number of those processes, not of the processes in memory. Returns
+	 * false case nothing was published.
+	 */
+	bool publishCompaction(bool wait, CompactionSwap & swap)
+	{
+		if (background == NULL || (!wait && !background->done.load(std::memory_order_acquire)))
+			return false;
+		background->worker.join();
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		BackgroundCompaction * job = background;
+		swap.buildSeconds = std::chrono::duration<double>(start - job->start).count();
+		swap.bytesMoved = job->bytesMoved;
+		swap.regionsMoved = job->regionsMoved;
+
+		//the arrivals go after the last process of order still in memory, released processes have name -1
+		Address next = 0;
+		for (std::size_t i = job->order.size(); i > 0 && next == 0; i--)
+			if (job->order[i - 1]->name >= 0)
+				next = job->records[i - 1].lastByte + 1;
+		Address needed = 0;
+		swap.arrivals = 0;
+		for (std::size_t i = 0; i < job->arrivals.size(); i++)
+			if (job->arrivals[i]->name >= 0)
+			{
+				needed += job->arrivals[i]->size;
+				swap.arrivals++;
+			}
+		swap.slid = next + needed - 1 > max;
+
+		//case the arrivals do not fit, slide in place and drop the new layout and arena
+		if (swap.slid)
+		{
+			if (job->target != NULL)
+				munmap(job->target, arenaSize);
+			std::thread(discardLayout, job->layout).detach();
+			::operator delete(job->records);
+			swap.bytesMoved = processes.compactProcesses(max, arena);
+			swap.regionsMoved = 0;
+		}
+		else
+		{
+			//the records of order released meanwhile are found by their old first byte, other retired records are skipped
+			for (Process * p = pool.retiredRecords(); p != NULL; p = p->next)
+			{
+				std::size_t i = std::lower_bound(job->from.begin(), job->from.end(), p->firstByte) - job->from.begin();
+				if (i == job->order.size() || job->order[i] != p)
+					continue;
+				Process * record = job->records + i;
+				job->layout->removeProcess(record, false);
+				if (record->handle >= 0)
+					job->handles[record->handle] = NULL;
+				pool.recycle(record, record);
+			}
+
+			//the extents still in memory point to their new records
+			for (std::size_t k = 0; k < job->extents.size(); k++)
+			{
+				std::size_t i = job->extents[k];
+				if (job->order[i]->name < 0)
+					continue;
+				Process * record = job->records + i;
+				record->slab = job->order[i]->slab;
+				record->zone = job->order[i]->zone;
+				if (record->slab != NULL)
+					record->slab->extent = record;
+				if (record->zone != NULL)
+					record->zone->extent = record;
+			}
+
+			//the arrivals move to the new list with their bytes and handles
+			job->handles.resize(handles.size(), NULL);
+			for (std::size_t i = 0; i < job->arrivals.size(); i++)
+			{
+				Process * p = job->arrivals[i];
+				if (p->name < 0)
+					continue;
+				Address from = p->firstByte;
+				processes.removeProcess(p, false);
+				job->layout->appendPacked(p);
+				if (job->target != NULL)
+					memcpy(job->target + p->firstByte, arena + from, p->size);
+				if (p->handle >= 0)
+					job->handles[p->handle] = p;
+			}
+
+			//what is left in the old list are the old records of order, their names pass to the new ones
+			Process * first = NULL;
+			Process * last = NULL;
+			processes.chain(first, last);
+			if (first != NULL)
+				pool.recycle(first, last);
+			if (job->records != NULL)
+				pool.adopt(job->records);
+			processes.swap(*job->layout);
+			handles.swap(job->handles);
+
+			//the old indexes and arena are given back off the command thread, no command can reach them anymore
+			std::thread(discardLayout, job->layout).detach();
+			if (arena != NULL)
+			{
+				std::thread(munmap, (void *) arena, arenaSize).detach();
+				arena = job->target;
+			}
+		}
+		pool.reclaim();
+		delete job;
+		background = NULL;
+		swap.pauseSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		return true;
+	}
+
+	/**
+	 * isCompacting - returns true case a background compaction is in flight
+	 */
+	bool isCompacting()
+	{
+		return background != NULL;
+	}
+
+	/**
+	 * isCompacted - returns true case free memory, if any, is a single gap at the high bytes,
+	 * of every shard case the memory is split
+	 */
+	bool isCompacted()
+	{
+		for (std::size_t k = 0; k < shards.size(); k++)
+		{
+			std::lock_guard<std::mutex> guard(shards[k]->lock);
+			if (!shards[k]->memory->isCompacted())
+				return false;
+		}
+		return processes.isCompacted();
+	}
+
+	/**
+	 * resolve - returns a pointer to the first byte of the process that received
+	 * handle, or NULL case the memory has no arena or the handle is not in use.
+	 */
+	char * resolve(int handle)
+	{
+		if (arena == NULL || handle < 0 || handle >= (int) handles.size() || handles[handle] == NULL)
+			return NULL;
+		return arena + addressOf(handles[handle]);
+	}
+
+	/**
+	 * isBacked - returns true case the memory is backed by a real arena
+	 */
+	bool isBacked()
+	{
+		return arena != NULL;
+	}
+
+}; //end of Memory class 
+
+//======================================================================
+/*
+ * ConcurrentMemory class - one linear memory shared by many worker threads.
+ * Every thread attaches a ThreadCache and allocates from chunks, extents of
+ * 64KB it reserves from the shared memory and manages with its own LinkedList,
+ * so small requests take no lock. Requests larger than half a chunk go straight
+ * to the shared memory. The shared memory is split by address range in regions,
+ * each with its own Memory and lock, and every thread reserves from its home
+ * region first, so threads only contend once their home region is full. A
+ * request larger than a region fails. Names are kept in a striped index, so
+ * any thread can release any process: a process in a chunk of another thread
+ * is pushed on that chunk's lock-free list of remote releases, and the owner
+ * gives the bytes back the next time it allocates. A chunk with no process left
+ * goes back to the shared memory. There is no compaction in this variant.
+ */
+class ConcurrentMemory
+{
+public:
+	class ThreadCache;
+
+private:
+	static const int chunkBytes = 65536;
+	static const int stripeCount = 64;
+	static const int maxRegions = 32;
+	static const Address minimumRegion = 16 * chunkBytes;
+
+	/*
+	 * Region - range of addresses of the shared memory with its own lock
+	 */
+	struct Region
+	{
+		std::mutex lock;
+		Memory * memory;   //addresses relative to base
+		Address base;
+	};
+
+	/*
+	 * RemoteRelease - node of the lock-free list of processes released by other threads
+	 */
+	struct RemoteRelease
+	{
+		Process * process;
+		RemoteRelease * next;
+	};
+
+	/*
+	 * Chunk - extent of the shared memory owned by one thread
+	 */
+	struct Chunk
+	{
+		Process * extent;                           //process in the shared memory that reserves the chunk
+		Region * region;                            //region holding the extent
+		LinkedList list;                            //processes in the chunk, addresses relative to the chunk
+		ThreadCache * owner;
+		int live;                                   //processes in the chunk, touched by the owner only
+		Address space;                              //largest free gap when last indexed by the owner
+		std::atomic<RemoteRelease *> remote;        //released by other threads, not yet given back
+
+		Chunk(Process * e, Region * r, ThreadCache * o, ProcessPool * pool) : list(chunkBytes - 1, pool)
+		{
+			extent = e;
+			region = r;
+			owner = o;
+			live = 0;
+			space = chunkBytes;
+			remote.store(NULL);
+		}
+	};
+
+	/*
+	 * Entry - where a process with a name lives, chunk is NULL for a large process in the shared memory
+	 */
+	struct Entry
+	{
+		Chunk * chunk;
+		Region * region;
+		Process * process;
+		Address address;
+	};
+
+	/*
+	 * Stripe - part of the name index with its own lock
+	 */
+	struct Stripe
+	{
+		std::mutex lock;
+		std::unordered_map<std::string, std::vector<Entry> > byName;
+	};
+
+	//instance data
+	std::vector<Region *> regions;
+	Stripe stripes[stripeCount];
+	std::atomic<int> chunkIds;
+	std::mutex cachesLock;
+	std::vector<ThreadCache *> caches;
+
+	/*
+	 * stripeOf - returns the stripe of the name index that holds name
+	 */
+	Stripe & stripeOf(const std::string & name)
+	{
+		return stripes[std::hash<std::string>()(name) % stripeCount];
+	}
+
+	/*
+	 * reserve - places a process with the name and size in the shared memory,
+	 * trying the home region of cache first and then the next ones. Locks one
+	 * region at a time. Returns the process, or NULL case no region has room.
+	 */
+	Process * reserve(ThreadCache * cache, const std::string & name, Address size, Region * & region)
+	{
+		for (std::size_t i = 0; i < regions.size(); i++)
+		{
+			region = regions[(cache->home + i) % regions.size()];
+			std::lock_guard<std::mutex> guard(region->lock);
+			LinkedList::Slot slot = region->memory->findMemorySlot(size);
+			if (slot.firstByte != -1)
+			{
+				Process * p = region->memory->newProcess(name, size);
+				region->memory->addProcessToMemory(p, slot);
+				return p;
+			}
+		}
+		region = NULL;
+		return NULL;
+	}
+
+	/*
+	 * unreserve - removes p, placed by reserve, from region
+	 */
+	void unreserve(Region * region, Process * p)
+	{
+		std::lock_guard<std::mutex> guard(region->lock);
+		region->memory->removeProcessFromMemory(p);
+	}
+
+	/*
+	 * reindex - files chunk of cache again under its current largest free gap
+	 */
+	void reindex(ThreadCache * cache, Chunk * chunk)
+	{
+		cache->bySpace.erase(std::make_pair(chunk->space, chunk));
+		chunk->space = chunk->list.largestGap();
+		cache->bySpace.insert(std::make_pair(chunk->space, chunk));
+	}
+
+	/*
+	 * giveBack - removes p from chunk, owned by the calling thread, and returns
+	 * the chunk to the shared memory case it is empty and not the thread's only chunk
+	 */
+	void giveBack(ThreadCache * cache, Chunk * chunk, Process * p)
+	{
+		chunk->list.removeProcess(p, true);
+		chunk->live--;
+		reindex(cache, chunk);
+		if (chunk->live == 0 && chunk->remote.load() == NULL && cache->chunks.size() > 1)
+		{
+			cache->chunks.erase(std::find(cache->chunks.begin(), cache->chunks.end(), chunk));
+			cache->bySpace.erase(std::make_pair(chunk->space, chunk));
+			unreserve(chunk->region, chunk->extent);
+			delete chunk;
+		}
+	}
+
+	/*
+	 * drain - gives back the processes other threads released from the chunks of cache
+	 */
+	void drain(ThreadCache * cache)
+	{
+		//chunks may go back to the shared memory while draining, walk a copy
+		std::vector<Chunk *> owned = cache->chunks;
+		for (std::size_t i = 0; i < owned.size(); i++)
+		{
+			RemoteRelease * node = owned[i]->remote.exchange(NULL);
+			while (node != NULL)
+			{
+				RemoteRelease * next = node->next;
+				giveBack(cache, owned[i], node->process);
+				delete node;
+				node = next;
+			}
+		}
+	}
+
+public:
+	/**
+	 * class ThreadCache - chunks owned by one worker thread. Must only be used by that thread.
+	 */
+	class ThreadCache
+	{
+	private:
+		std::vector<Chunk *> chunks;
+		std::set<std::pair<Address, Chunk *> > bySpace;   //chunks by largest free gap
+		ProcessPool pool;                             //processes in the chunks
+		std::size_t home;                             //region tried first
+		friend class ConcurrentMemory;
+	};
+
+	/**
+	 * ConcurrentMemory constructor - shared memory with last byte m, split in
+	 * up to maxRegions regions of at least minimumRegion bytes, the last region
+	 * takes the bytes left over
+	 */
+	ConcurrentMemory(Address m)
+	{
+		chunkIds.store(0);
+		Address count = std::max((Address) 1, std::min((Address) maxRegions, (m + 1) / minimumRegion));
+		Address length = (m + 1) / count;
+		for (Address k = 0; k < count; k++)
+		{
+			Region * region = new Region;
+			region->base = k * length;
+			region->memory = new Memory((k == count - 1) ? m - region->base : length - 1);
+			regions.push_back(region);
+		}
+	}
+
+	/**
+	 * ConcurrentMemory destructor - deallocates the caches, their chunks and the processes in them
+	 */
+	~ConcurrentMemory()
+	{
+		for (std::size_t i = 0; i < caches.size(); i++)
+		{
+			for (std::size_t c = 0; c < caches[i]->chunks.size(); c++)
+			{
+				RemoteRelease * node = caches[i]->chunks[c]->remote.load();
+				while (node != NULL)
+				{
+					RemoteRelease * next = node->next;
+					delete node;
+					node = next;
+				}
+				delete caches[i]->chunks[c];
+			}
+			delete caches[i];
+		}
+		for (std::size_t k = 0; k < regions.size(); k++)
+		{
+			delete regions[k]->memory;
+			delete regions[k];
+		}
+	}
+
+	/**
+	 * attach - returns a new cache for the calling thread
+	 */
+	ThreadCache * attach()
+	{
+		std::lock_guard<std::mutex> guard(cachesLock);
+		caches.push_back(new ThreadCache());
+		caches.back()->home = (caches.size() - 1) % regions.size();
+		return caches.back();
+	}
+
+	/**
+	 * request - allocates size bytes for a process with the name, using the
+	 * chunks of cache for small requests. Returns the first byte of the process
+	 * in memory, or -1 case there is no room.
+	 */
+	Address request(ThreadCache * cache, const std::string & name, Address size)
+	{
+		drain(cache);
+		Entry entry = { NULL, NULL, NULL, -1 };
+
+		if (size <= chunkBytes / 2)
+		{
+			//the owned chunk with the smallest largest gap that fits, then best fit in it
+			std::set<std::pair<Address, Chunk *> >::iterator fit = cache->bySpace.lower_bound(std::make_pair(size, (Chunk *) NULL));
+			if (fit != cache->bySpace.end())
+			{
+				entry.chunk = fit->second;
+				entry.process = cache->pool.create(name, size);
+				entry.chunk->list.addProcessToList(entry.process, entry.chunk->list.findSpotInList(size));
+			}
+
+			//otherwise reserve a new chunk from the shared memory
+			if (entry.chunk == NULL)
+			{
+				Process * extent = reserve(cache, "chunk " + std::to_string(chunkIds.fetch_add(1)), chunkBytes, entry.region);
+				if (extent == NULL)
+					return -1;
+				entry.chunk = new Chunk(extent, entry.region, cache, &cache->pool);
+				cache->chunks.push_back(entry.chunk);
+				entry.process = cache->pool.create(name, size);
+				entry.chunk->list.addProcessToList(entry.process, entry.chunk->list.findSpotInList(size));
+			}
+			entry.chunk->live++;
+			reindex(cache, entry.chunk);
+			entry.region = entry.chunk->region;
+			entry.address = entry.region->base + entry.chunk->extent->firstByte + entry.process->firstByte;
+		}
+
+		//case a large request, straight to the shared memory
+		else
+		{
+			entry.process = reserve(cache, name, size, entry.region);
+			if (entry.process == NULL)
+				return -1;
+			entry.address = entry.region->base + entry.process->firstByte;
+		}
+
+		Stripe & stripe = stripeOf(name);
+		std::lock_guard<std::mutex> guard(stripe.lock);
+		stripe.byName[name].push_back(entry);
+		return entry.address;
+	}
+
+	/**
+	 * release - releases the lowest address process with the name, from any thread.
+	 * Returns false case no process has the name.
+	 */
+	bool release(ThreadCache * cache, const std::string & name)
+	{
+		Entry entry;
+		{
+			Stripe & stripe = stripeOf(name);
+			std::lock_guard<std::mutex> guard(stripe.lock);
+			std::unordered_map<std::string, std::vector<Entry> >::iterator match = stripe.byName.find(name);
+			if (match == stripe.byName.end())
+				return false;
+			std::size_t lowest = 0;
+			for (std::size_t i = 1; i < match->second.size(); i++)
+				if (match->second[i].address < match->second[lowest].address)
+					lowest = i;
+			entry = match->second[lowest];
+			match->second[lowest] = match->second.back();
+			match->second.pop_back();
+			if (match->second.empty())
+				stripe.byName.erase(match);
+		}
+
+		//case a large process in the shared memory
+		if (entry.chunk == NULL)
+			unreserve(entry.region, entry.process);
+		//case a process in a chunk of the calling thread
+		else if (entry.chunk->owner == cache)
+			giveBack(cache, entry.chunk, entry.process);
+		//case a process in a chunk of another thread, the owner gives the bytes back
+		else
+		{
+			RemoteRelease * node = new RemoteRelease;
+			node->process = entry.process;
+			node->next = entry.chunk->remote.load();
+			while (!entry.chunk->remote.compare_exchange_weak(node->next, node))
+				;
+		}
+		return true;
+	}
+};
+
+//======================================================================
+/*
+ * ExtentTable class - alternative layout for the processes of a small memory.
+ * Processes are kept in address order in three plain arrays, their first
+ * bytes, last bytes and owners, instead of linked Process records. The gap
+ * before every process is the difference of two neighbouring array entries,
+ * so best fit is a straight scan of memory that the AVX2 or SSE4.1 kernels
+ * run eight or four gaps at a time. The kernel is picked at runtime from what
+ * the processor supports, with a scalar kernel everywhere else. Entries are
+ * 32 bit so more of them fit in a vector, the table is for memories below 2GB.
+ */
+class ExtentTable
+{
+public:
+	enum Kernel { SCALAR, SSE41, AVX2 };
+
+private:
+	int max;                   //last byte available in memory
+	std::vector<int> starts;   //first byte of every process, in address order
+	std::vector<int> ends;     //last byte of every process
+	std::vector<int> owners;   //name id of every process
+	Kernel kernel;
+
+	/*
+	 * gapBefore - returns the size of the free gap before position, the gap
+	 * after the last process when position is the process count
+	 */
+	int gapBefore(std::size_t position) const
+	{
+		int first = (position == 0) ? 0 : ends[position - 1] + 1;
+		int last = (position == starts.size()) ? max : starts[position] - 1;
+		return last - first + 1;
+	}
+
+	/*
+	 * scanScalar - returns the smallest gap before positions [from : to) not
+	 * smaller than size, INT_MAX case none is
+	 */
+	int scanScalar(std::size_t from, std::size_t to, int size) const
+	{
+		int best = INT_MAX;
+		for (std::size_t i = from; i < to; i++)
+		{
+			int gap = starts[i] - ends[i - 1] - 1;
+			best = (gap >= size && gap < best) ? gap : best;
+		}
+		return best;
+	}
+
+	/*
+	 * locateScalar - returns the first position in [from : to) with a gap
+	 * before it of exactly gap bytes, to case there is none
+	 */
+	std::size_t locateScalar(std::size_t from, std::size_t to, int gap) const
+	{
+		for (std::size_t i = from; i < to; i++)
+			if (starts[i] - ends[i - 1] - 1 == gap)
+				return i;
+		return to;
+	}
+
+#if defined(__x86_64__) || defined(__i386__)
+	/*
+	 * scanSse41 - scanScalar four gaps at a time
+	 */
+	__attribute__((target("sse4.1")))
+	int scanSse41(std::size_t from, std::size_t to, int size) const
+	{
+		__m128i best = _mm_set1_epi32(INT_MAX);
+		__m128i below = _mm_set1_epi32(size - 1);
+		std::size_t i = from;
+		for (; i + 4 <= to; i += 4)
+		{
+			__m128i start = _mm_loadu_si128((const __m128i *) &starts[i]);
+			__m128i end = _mm_loadu_si128((const __m128i *) &ends[i - 1]);
+			__m128i gap = _mm_sub_epi32(_mm_sub_epi32(start, end), _mm_set1_epi32(1));
+			__m128i fits = _mm_cmpgt_epi32(gap, below);
+			best = _mm_min_epi32(best, _mm_blendv_epi8(_mm_set1_epi32(INT_MAX), gap, fits));
+		}
+		best = _mm_min_epi32(best, _mm_shuffle_epi32(best, _MM_SHUFFLE(1, 0, 3, 2)));
+		best = _mm_min_epi32(best, _mm_shuffle_epi32(best, _MM_SHUFFLE(2, 3, 0, 1)));
+		return std::min(_mm_cvtsi128_si32(best), scanScalar(i, to, size));
+	}
+
+	/*
+	 * locateSse41 - locateScalar four gaps at a time
+	 */
+	__attribute__((target("sse4.1")))
+	std::size_t locateSse41(std::size_t from, std::size_t to, int gap) const
+	{
+		__m128i want = _mm_set1_epi32(gap + 1);
+		std::size_t i = from;
+		for (; i + 4 <= to; i += 4)
+		{
+			__m128i start = _mm_loadu_si128((const __m128i *) &starts[i]);
+			__m128i end = _mm_loadu_si128((const __m128i *) &ends[i - 1]);
+			int mask = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(_mm_sub_epi32(start, end), want)));
+			if (mask != 0)
+				return i + __builtin_ctz(mask);
+		}
+		return locateScalar(i, to, gap);
+	}
+
+	/*
+	 * scanAvx2 - scanScalar eight gaps at a time
+	 */
+	__attribute__((target("avx2")))
+	int scanAvx2(std::size_t from, std::size_t to, int size) const
+	{
+		__m256i best = _mm256_set1_epi32(INT_MAX);
+		__m256i below = _mm256_set1_epi32(size - 1);
+		std::size_t i = from;
+		for (; i + 8 <= to; i += 8)
+		{
+			__m256i start = _mm256_loadu_si256((const __m256i *) &starts[i]);
+			__m256i end = _mm256_loadu_si256((const __m256i *) &ends[i - 1]);
+			__m256i gap = _mm256_sub_epi32(_mm256_sub_epi32(start, end), _mm256_set1_epi32(1));
+			__m256i fits = _mm256_cmpgt_epi32(gap, below);
+			best = _mm256_min_epi32(best, _mm256_blendv_epi8(_mm256_set1_epi32(INT_MAX), gap, fits));
+		}
+		__m128i half = _mm_min_epi32(_mm256_castsi256_si128(best), _mm256_extracti128_si256(best, 1));
+		half = _mm_min_epi32(half, _mm_shuffle_epi32(half, _MM_SHUFFLE(1, 0, 3, 2)));
+		half = _mm_min_epi32(half, _mm_shuffle_epi32(half, _MM_SHUFFLE(2, 3, 0, 1)));
+		return std::min(_mm_cvtsi128_si32(half), scanScalar(i, to, size));
+	}
+
+	/*
+	 * locateAvx2 - locateScalar eight gaps at a time
+	 */
+	__attribute__((target("avx2")))
+	std::size_t locateAvx2(std::size_t from, std::size_t to, int gap) const
+	{
+		__m256i want = _mm256_set1_epi32(gap + 1);
+		std::size_t i = from;
+		for (; i + 8 <= to; i += 8)
+		{
+			__m256i start = _mm256_loadu_si256((const __m256i *) &starts[i]);
+			__m256i end = _mm256_loadu_si256((const __m256i *) &ends[i - 1]);
+			int mask = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_sub_epi32(start, end), want)));
+			if (mask != 0)
+				return i + __builtin_ctz(mask);
+		}
+		return locateScalar(i, to, gap);
+	}
+#endif
+
+	/*
+	 * scan - scanScalar with the kernel in use
+	 */
+	int scan(std::size_t from, std::size_t to, int size) const
+	{
+#if defined(__x86_64__) || defined(__i386__)
+		if (kernel == AVX2)
+			return scanAvx2(from, to, size);
+		if (kernel == SSE41)
+			return scanSse41(from, to, size);
+#endif
+		return scanScalar(from, to, size);
+	}
+
+	/*
+	 * locate - locateScalar with the kernel in use
+	 */
+	std::size_t locate(std::size_t from, std::size_t to, int gap) const
+	{
+#if defined(__x86_64__) || defined(__i386__)
+		if (kernel == AVX2)
+			return locateAvx2(from, to, gap);
+		if (kernel == SSE41)
+			return locateSse41(from, to, gap);
+#endif
+		return locateScalar(from, to, gap);
+	}
+
+public:
+	/**
+	 * ExtentTable constructor - memory [0 : m] with no process, using the
+	 * best kernel the processor supports
+	 */
+	ExtentTable(int m)
+	{
+		max = m;
+		kernel = bestKernel();
+	}
+
+	/**
+	 * bestKernel - returns the widest kernel the processor supports
+	 */
+	static Kernel bestKernel()
+	{
+#if defined(__x86_64__) || defined(__i386__)
+		if (__builtin_cpu_supports("avx2"))
+			return AVX2;
+		if (__builtin_cpu_supports("sse4.1"))
+			return SSE41;
+#endif
+		return SCALAR;
+	}
+
+	/**
+	 * useKernel - scans with kernel from now on, case the processor supports it
+	 */
+	void useKernel(Kernel k)
+	{
+		if (k <= bestKernel())
+			kernel = k;
+	}
+
+	/**
+	 * kernelName - returns the name of the kernel in use
+	 */
+	const char * kernelName() const
+	{
+		return kernel == AVX2 ? "avx2" : (kernel == SSE41 ? "sse4.1" : "scalar");
+	}
+
+	/**
+	 * findBestFit - returns the first byte of the smallest free gap that holds
+	 * size bytes, the lowest one among gaps of the same size, or -1 case there
+	 * is no room. position is set to where the process goes in the table.
+	 */
+	int findBestFit(int size, std::size_t & position) const
+	{
+		//the gaps before the first process and after the last one are not between two entries
+		int best = gapBefore(0) >= size ? gapBefore(0) : INT_MAX;
+		if (!starts.empty())
+		{
+			best = std::min(best, scan(1, starts.size(), size));
+			int tail = gapBefore(starts.size());
+			if (tail >= size && tail < best)
+				best = tail;
+		}
+		if (best == INT_MAX)
+			return -1;
+
+		//lowest gap of that size, the one after the last process when no other is
+		position = (gapBefore(0) == best) ? 0 : locate(1, starts.size(), best);
+		return position == 0 ? 0 : ends[position - 1] + 1;
+	}
+
+	/**
+	 * insert - adds a process of size bytes at first, owned by owner, at position
+	 * returned by findBestFit, or found with positionOf
+	 */
+	void insert(std::size_t position, int first, int size, int owner)
+	{
+		starts.insert(starts.begin() + position, first);
+		ends.insert(ends.begin() + position, first + size - 1);
+		owners.insert(owners.begin() + position, owner);
+	}
+
+	/**
+	 * positionOf - returns the position of the first process at or after byte first
+	 */
+	std::size_t positionOf(int first) const
+	{
+		return std::lower_bound(starts.begin(), starts.end(), first) - starts.begin();
+	}
+
+	/**
+	 * remove - removes the process at position
+	 */
+	void remove(std::size_t position)
+	{
+		starts.erase(starts.begin() + position);
+		ends.erase(ends.begin() + position);
+		owners.erase(owners.begin() + position);
+	}
+
+	/**
+	 * size - returns the number of processes in the table
+	 */
+	std::size_t size() const
+	{
+		return starts.size();
+	}
+};
+
+//=================================================================
+
+/**
+ * class LatencyRecorder - collects latency samples in nanoseconds for one
+ * operation and reports its percentiles.
+ */
+class LatencyRecorder
+{
+private:
+	//instance data
+	std::vector<long> samples;
+
+public:
+	/**
+	 * record - adds one sample, in nanoseconds
+	 */
+	void record(long nanoseconds)
+	{
+		samples.push_back(nanoseconds);
+	}
+
+	/**
+	 * count - returns the number of samples recorded
+	 */
+	std::size_t count()
+	{
+		return samples.size();
+	}
+
+	/**
+	 * percentile - returns the sample at fraction p (0.5 for p50) of the sorted
+	 * samples, or 0 case there are no samples.
+	 */
+	long percentile(double p)
+	{
+		if (samples.empty())
+			return 0;
+		std::size_t rank = (std::size_t) (p * (samples.size() - 1));
+		std::nth_element(samples.begin(), samples.begin() + rank, samples.end());
+		return samples[rank];
+	}
+
+	/**
+	 * merge - adds the samples of other
+	 */
+	void merge(const LatencyRecorder & other)
+	{
+		samples.insert(samples.end(), other.samples.begin(), other.samples.end());
+	}
+
+	/**
+	 * toString - returns a table row with the count, p50, p99 and p999 of the samples
+	 */
+	std::string toString(std::string name)
+	{
+		char buffer[120];
+		sprintf(buffer, "%-26s %10lu %10ld %10ld %10ld", name.c_str(), (unsigned long) count(),
+				percentile(0.5), percentile(0.99), percentile(0.999));
+		return std::string(buffer);
+	}
+};
+
+//=================================================================
+
+/**
+ * class Benchmark - drives Memory directly with a synthetic workload and
+ * reports the latency of its operations. The heap is first filled to the
+ * occupancy level, then requests and releases alternate. Request sizes follow
+ * a uniform, power-law or bimodal distribution and releases follow a LIFO,
+ * FIFO or random order. Failed requests compact the memory once and retry.
+ */
+class Benchmark
+{
+private:
+	//instance data, workload configuration
+	std::string distribution;   //uniform, powerlaw or bimodal
+	std::string releaseOrder;   //lifo, fifo or random
+	double occupancy;           //fraction of memory kept allocated
+	long operations;            //request and release pairs after the heap is filled
+	Address minSize;
+	Address maxSize;
+	unsigned long seed;
+	long stepBudget;            //bytes per incremental compaction step after every operation, 0 when disabled
+	bool planned;               //compact with the move-minimizing planner
+	char strategy;              //placement strategy letter, B, F, N or W
+	int threads;                //most worker threads for the concurrent benchmark, 0 to drive Memory directly
+	int extents;                //most processes for the extent table benchmark, 0 when it is not run
+
+	/*
+	 * nextSize - draws one request size from the configured distribution
+	 */
+	Address nextSize(std::mt19937_64 & random)
+	{
+		if (distribution == "powerlaw")
+		{
+			//Pareto with alpha 1.5, truncated to the maximum size
+			std::uniform_real_distribution<double> unit(0.0, 1.0);
+			double size = minSize / std::pow(1.0 - unit(random), 1.0 / 1.5);
+			return size > maxSize ? maxSize : (Address) size;
+		}
+		if (distribution == "bimodal")
+		{
+			//nine small requests out of ten, small ones stay in the lowest sixteenth of the range
+			std::uniform_int_distribution<int> coin(0, 9);
+			Address split = minSize + (maxSize - minSize) / 16;
+			if (coin(random) != 0)
+				return std::uniform_int_distribution<Address>(minSize, split)(random);
+			return std::uniform_int_distribution<Address>(split, maxSize)(random);
+		}
+		return std::uniform_int_distribution<Address>(minSize, maxSize)(random);
+	}
+
+	/*
+	 * nextVictim - picks the position in live of the next process to release
+	 */
+	std::size_t nextVictim(std::deque<std::pair<std::string, Address> > & live, std::mt19937_64 & random)
+	{
+		if (releaseOrder == "lifo")
+			return live.size() - 1;
+		if (releaseOrder == "fifo")
+			return 0;
+		return std::uniform_int_distribution<std::size_t>(0, live.size() - 1)(random);
+	}
+
+	/*
+	 * elapsed - nanoseconds since start
+	 */
+	static long elapsed(std::chrono::steady_clock::time_point start)
+	{
+		return (long) std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+	}
+
+public:
+	/**
+	 * Benchmark constructor - uniform sizes between 16 and 4096 bytes,
+	 * random releases, 80% occupancy and 100000 operations.
+	 */
+	Benchmark()
+	{
+		distribution = "uniform";
+		releaseOrder = "random";
+		occupancy = 0.8;
+		operations = 100000;
+		minSize = 16;
+		maxSize = 4096;
+		seed = 1;
+		stepBudget = 0;
+		planned = false;
+		strategy = 'B';
+		threads = 0;
+		extents = 0;
+	}
+
+	/**
+	 * parseOption - consumes the benchmark option at values[i] and its value.
+	 * Returns false case the option is not a benchmark option or its value does not parse, the ranges are checked by isValid.
+	 * 		--dist uniform|powerlaw|bimodal   --release lifo|fifo|random
+	 * 		--occupancy <0..1>   --ops <n>   --min <bytes>   --max <bytes>   --seed <n>
+	 * 		--step <bytes>   --compact slide|plan   --fit B|F|N|W|U   --threads <n>   --extents <n>
+	 */
+	bool parseOption(int & i, int count, char ** values)
+	{
+		if (i + 1 >= count)
+			return false;
+		std::string option = values[i];
+		std::string value = values[i + 1];
+		try
+		{
+			if (option == "--dist" && (value == "uniform" || value == "powerlaw" || value == "bimodal"))
+				distribution = value;
+			else if (option == "--release" && (value == "lifo" || value == "fifo" || value == "random"))
+				releaseOrder = value;
+			else if (option == "--occupancy")
+				occupancy = std::stod(value);
+			else if (option == "--ops")
+				operations = std::stol(value);
+			else if (option == "--min")
+				minSize = std::stoll(value);
+			else if (option == "--max")
+				maxSize = std::stoll(value);
+			else if (option == "--seed")
+				seed = std::stoul(value);
+			else if (option == "--step")
+				stepBudget = std::stol(value);
+			else if (option == "--compact" && (value == "slide" || value == "plan"))
+				planned = (value == "plan");
+			else if (option == "--fit" && Memory::isStrategy(value))
+				strategy = value[0];
+			else if (option == "--threads")
+				threads = std::stoi(value);
+			else if (option == "--extents")
+				extents = std::stoi(value);
+			else
+				return false;
+		}
+		catch(const std::exception &x)
+		{
+			return false;
+		}
+		i++;
+		return true;
+	}
+
+	/**
+	 * isValid - checks the options once they are all parsed, since --min may
+	 * only fit the default --max after --max is read too.
+	 */
+	bool isValid() const
+	{
+		return occupancy > 0 && occupancy <= 1 && operations >= 0 && minSize > 0 && maxSize >= minSize && stepBudget >= 0 && threads >= 0 && extents >= 0;
+	}
+
+	/**
+	 * runExtents - compares best fit in an ExtentTable, with the widest kernel
+	 * and with the scalar one, against best fit in the linked list of a Memory,
+	 * walking the processes and searching the gap index, for 256, 1024, 4096, ... up to the configured number of
+	 * processes. Both are filled with twice that many processes side by side and
+	 * a random half is released, then the operations are lookups only. Every
+	 * lookup must find the same first byte in the table as in the list.
+	 */
+	void runExtents(std::ostream & out)
+	{
+		out << "\nExtent table benchmark: " << distribution << " sizes [" << minSize << " : " << maxSize << "], "
+				<< operations << " best fit lookups per size\n\n";
+		char buffer[160];
+		std::string widest = std::string("SoA ") + ExtentTable(0).kernelName() + " ns";
+		sprintf(buffer, "%-10s %16s %16s %16s %16s %10s", "Processes", widest.c_str(), "SoA scalar ns",
+				"list walk ns", "gap index ns", "mismatch");
+		out << buffer << "\n";
+
+		for (long count = 256; ; count = std::min(count * 4, (long) extents))
+		{
+			if (2 * count * maxSize >= INT_MAX)
+			{
+				out << "Memory for " << count << " processes of up to " << maxSize << " bytes does not fit in an int\n";
+				break;
+			}
+			int last = (int) (2 * count * maxSize);
+			Memory memory(last);
+			ExtentTable table(last);
+			std::mt19937_64 random(seed);
+
+			//fill side by side, then release a random half
+			std::vector<std::pair<std::string, Address> > placed;
+			for (long k = 0; k < 2 * count; k++)
+			{
+				int size = (int) nextSize(random);
+				LinkedList::Slot slot = memory.findMemorySlot<BestFit>(size);
+				std::string name = "E" + std::to_string(k);
+				memory.addProcessToMemory(memory.newProcess(name, size), slot);
+				table.insert(table.size(), (int) slot.firstByte, size, (int) k);
+				placed.push_back(std::make_pair(name, slot.firstByte));
+			}
+			for (std::size_t k = 0; k < placed.size(); k++)
+				if (random() % 2 == 0)
+				{
+					memory.removeProcessFromMemory(placed[k].first);
+					table.remove(table.positionOf((int) placed[k].second));
+				}
+
+			std::vector<int> sizes;
+			for (long k = 0; k < operations; k++)
+				sizes.push_back((int) nextSize(random));
+			std::vector<Address> found[4];
+			double nanoseconds[4];
+			for (int run = 0; run < 4; run++)
+			{
+				found[run].reserve(sizes.size());
+				if (run == 1)
+					table.useKernel(ExtentTable::SCALAR);
+				std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+				for (std::size_t k = 0; k < sizes.size(); k++)
+				{
+					std::size_t position;
+					if (run < 2)
+						found[run].push_back(table.findBestFit(sizes[k], position));
+					else if (run == 2)
+						found[run].push_back(memory.findMemorySlot<WalkBestFit>(sizes[k]).firstByte);
+					else
+						found[run].push_back(memory.findMemorySlot<BestFit>(sizes[k]).firstByte);
+				}
+				nanoseconds[run] = (double) elapsed(start) / (sizes.empty() ? 1 : sizes.size());
+			}
+			long mismatches = 0;
+			for (std::size_t k = 0; k < sizes.size(); k++)
+				if (found[0][k] != found[3][k] || found[1][k] != found[3][k] || found[2][k] != found[3][k])
+					mismatches++;
+
+			sprintf(buffer, "%-10lu %16.1f %16.1f %16.1f %16.1f %10ld", (unsigned long) table.size(),
+					nanoseconds[0], nanoseconds[1], nanoseconds[2], nanoseconds[3], mismatches);
+			out << buffer << "\n";
+			if (count >= extents)
+				break;
+		}
+		out << "\n";
+	}
+
+	/**
+	 * runConcurrent - runs the workload against a ConcurrentMemory with last byte
+	 * max, with 1, 2, 4, ... up to the configured number of worker threads, and
+	 * writes the throughput of every run to out. Each thread keeps its share of
+	 * the occupancy. One request in ten is handed to the next thread, which
+	 * releases it, so releases also cross threads.
+	 */
+	void runConcurrent(Address max, std::ostream & out)
+	{
+		out << "\nConcurrent benchmark: " << distribution << " sizes [" << minSize << " : " << maxSize << "], "
+				<< (occupancy * 100) << "% occupancy, " << operations << " operations, memory [0 : " << max << "]\n\n";
+		char buffer[120];
+		sprintf(buffer, "%-10s %16s %10s %10s", "Threads", "operations/sec", "speedup", "failed");
+		out << buffer << "\n";
+
+		double single = 0;
+		for (int count = 1; count <= threads; count = (count * 2 > threads && count < threads) ? threads : count * 2)
+		{
+			ConcurrentMemory memory(max);
+			long budget = (long) (occupancy * ((double) max + 1) / count);   //live bytes each thread keeps
+			long perThread = operations / count;
+			std::atomic<long> failures(0);
+
+			//names handed from every thread to the next one
+			std::vector<std::mutex> locks(count);
+			std::vector<std::vector<std::string> > inboxes(count);
+
+			std::vector<std::thread> workers;
+			std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+			for (int id = 0; id < count; id++)
+				workers.push_back(std::thread([&, id]()
+				{
+					ConcurrentMemory::ThreadCache * cache = memory.attach();
+					std::mt19937_64 random(seed + id);
+					std::deque<std::pair<std::string, Address> > live;
+					long usedBytes = 0;
+					long names = 0;
+					for (long op = 0; op < perThread; op++)
+					{
+						//release what other threads handed over first
+						std::vector<std::string> handed;
+						{
+							std::lock_guard<std::mutex> guard(locks[id]);
+							handed.swap(inboxes[id]);
+						}
+						for (std::size_t i = 0; i < handed.size(); i++)
+							memory.release(cache, handed[i]);
+
+						Address size = nextSize(random);
+						if (usedBytes + size > budget && !live.empty())
+						{
+							std::size_t victim = nextVictim(live, random);
+							memory.release(cache, live[victim].first);
+							usedBytes -= live[victim].second;
+							//order only matters to lifo and fifo, a random victim swaps with the last
+							if (releaseOrder == "random")
+							{
+								live[victim] = live.back();
+								live.pop_back();
+							}
+							else
+								live.erase(live.begin() + victim);
+							continue;
+						}
+						std::string name = "T" + std::to_string(id) + "_" + std::to_string(names++);
+						if (memory.request(cache, name, size) < 0)
+							failures++;
+						else if (names % 10 == 0)
+						{
+							std::lock_guard<std::mutex> guard(locks[(id + 1) % count]);
+							inboxes[(id + 1) % count].push_back(name);
+						}
+						else
+						{
+							live.push_back(std::make_pair(name, size));
+							usedBytes += size;
+						}
+					}
+				}));
+			for (std::size_t i = 0; i < workers.size(); i++)
+				workers[i].join();
+			double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+			double rate = perThread * count / (seconds > 0 ? seconds : 1);
+			if (count == 1)
+				single = rate;
+			sprintf(buffer, "%-10d %16.0f %9.2fx %10ld", count, rate, single > 0 ? rate / single : 0, failures.load());
+			out << buffer << "\n";
+			if (count == threads)
+				break;
+		}
+		out << "\n";
+	}
+
+	/**
+	 * run - runs the workload against memory, an empty memory with last byte max,
+	 * and writes the report to out. Case the memory is backed by a real arena,
+	 * every request writes its bytes and compaction moves them.
+	 */
+	void run(Memory & memory, Address max, std::ostream & out)
+	{
+		//case the concurrent variant is measured instead
+		if (threads > 0)
+		{
+			runConcurrent(max, out);
+			return;
+		}
+
+		//case the extent table is measured instead
+		if (extents > 0)
+		{
+			runExtents(out);
+			return;
+		}
+
+		std::mt19937_64 random(seed);
+		std::deque<std::pair<std::string, Address> > live;   //live process names and sizes, oldest first
+		long usedBytes = 0;
+		long target = (long) (occupancy * ((double) max + 1));
+		long nameCounter = 0;
+		long failures = 0;
+		long compactedBytes = 0;
+		long compactNanoseconds = 0;
+
+		LatencyRecorder find, add, remove, compact, step;
+
+		//mean request latency grouped by live region count, bucket k holds counts in [2^k : 2^(k+1) - 1]
+		std::vector<long> bucketTime(64, 0), bucketCount(64, 0);
+
+		std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+		long requests = 0, releases = 0;
+
+		//fill phase runs until the occupancy target, then requests and releases alternate
+		long steady = 0;
+		while (steady < operations)
+		{
+			//case incremental compaction is on, take one step between operations
+			if (stepBudget > 0 && !memory.isCompacted())
+			{
+				int regions = 0;
+				std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+				compactedBytes += memory.compactMemoryStep(stepBudget, regions);
+				long stepTime = elapsed(start);
+				step.record(stepTime);
+				compactNanoseconds += stepTime;
+			}
+
+			bool filling = usedBytes < target;
+			if (!filling)
+			{
+				//release one process in the configured order
+				if (!live.empty())
+				{
+					std::size_t victim = nextVictim(live, random);
+					std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+					memory.removeProcessFromMemory(live[victim].first);
+					remove.record(elapsed(start));
+					usedBytes -= live[victim].second;
+					live.erase(live.begin() + victim);
+					releases++;
+				}
+				steady++;
+			}
+
+			//request one process
+			Address size = nextSize(random);
+			std::string name = "B" + std::to_string(nameCounter++);
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			LinkedList::Slot slot = memory.findMemorySlot(size, strategy);
+			long findTime = elapsed(start);
+			find.record(findTime);
+
+			//case no gap fits, compact once and try again
+			if (slot.firstByte == -1)
+			{
+				start = std::chrono::steady_clock::now();
+				compactedBytes += planned ? memory.compactMemoryPlanned().bytesMoved : memory.compactMemory(max);
+				long compactTime = elapsed(start);
+				compact.record(compactTime);
+				compactNanoseconds += compactTime;
+				start = std::chrono::steady_clock::now();
+				slot = memory.findMemorySlot(size, strategy);
+				findTime += elapsed(start);
+				find.record(elapsed(start));
+			}
+			if (slot.firstByte == -1)
+			{
+				failures++;
+				//memory too full for this size, stop filling
+				if (filling)
+					target = usedBytes;
+				continue;
+			}
+
+			Process * process = memory.newProcess(name, size);
+			start = std::chrono::steady_clock::now();
+			int handle = memory.addProcessToMemory(process, slot);
+			long addTime = elapsed(start);
+			add.record(addTime);
+
+			//touch the bytes, so compaction of an arena moves real data
+			if (handle >= 0)
+				memset(memory.resolve(handle), (int) (nameCounter & 0xff), size);
+			live.push_back(std::make_pair(name, size));
+			usedBytes += size;
+			requests++;
+
+			int bucket = 0;
+			while ((2UL << bucket) <= live.size())
+				bucket++;
+			bucketTime[bucket] += findTime + addTime;
+			bucketCount[bucket]++;
+		}
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+		//report
+		out << "\nBenchmark: " << strategy << " fit, " << distribution << " sizes [" << minSize << " : " << maxSize << "], "
+				<< releaseOrder << " release, " << (occupancy * 100) << "% occupancy, "
+				<< operations << " operations, memory [0 : " << max << "]\n\n";
+		char buffer[120];
+		sprintf(buffer, "%-26s %10s %10s %10s %10s", "Operation (ns)", "count", "p50", "p99", "p999");
+		out << buffer << "\n";
+		out << find.toString("findMemorySlot") << "\n";
+		out << add.toString("addProcessToMemory") << "\n";
+		out << remove.toString("removeProcessFromMemory") << "\n";
+		out << compact.toString("compactMemory") << "\n";
+		if (stepBudget > 0)
+			out << step.toString("compactMemoryStep") << "\n";
+		out << "\n";
+		out << "Throughput: " << (long) ((requests + releases) / (seconds > 0 ? seconds : 1)) << " operations/sec ("
+				<< requests << " requests, " << releases << " releases, " << failures << " failed, in "
+				<< seconds << " seconds)\n";
+		out << "Compaction: " << compactedBytes << " bytes moved" << (memory.isBacked() ? " in the arena, " : " (simulated), ")
+				<< (compactNanoseconds > 0 ? compactedBytes * 1e9 / compactNanoseconds / 1048576 : 0) << " MB/s\n";
+		out << memory.sizeClassesToString() << "\n";
+
+		sprintf(buffer, "%-26s %10s %14s", "Live regions", "requests", "mean RQ ns");
+		out << buffer << "\n";
+		for (int k = 0; k < 64; k++)
+		{
+			if (bucketCount[k] == 0)
+				continue;
+			char range[40];
+			sprintf(range, "[%lu : %lu]", 1UL << k, (2UL << k) - 1);
+			sprintf(buffer, "%-26s %10ld %14ld", range, bucketCount[k], bucketTime[k] / bucketCount[k]);
+			out << buffer << "\n";
+		}
+		out << "\n";
+	}
+};
+
+//=================================================================
+/*
+ * serverStopping - set by SIGINT and SIGTERM so the server loop closes its
+ * connections and returns
+ */
+volatile sig_atomic_t serverStopping = 0;
+
+inline void stopServing(int)
+{
+	serverStopping = 1;
+}
+
+/*
+ * openSocket - returns a socket for address, a localhost TCP port case it is
+ * all digits and a Unix domain socket path otherwise. Case listening is true the
+ * socket is bound and listens, replacing a stale socket file, otherwise it is
+ * connected. Returns -1 case that fails.
+ */
+inline int openSocket(const std::string & address, bool listening)
+{
+	bool tcp = !address.empty() && address.find_first_not_of("0123456789") == std::string::npos;
+	sockaddr_in inet;
+	sockaddr_un local;
+	sockaddr * name;
+	socklen_t length;
+	if (tcp)
+	{
+		memset(&inet, 0, sizeof(inet));
+		inet.sin_family = AF_INET;
+		inet.sin_port = htons((unsigned short) atoi(address.c_str()));
+		inet.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+		name = (sockaddr *) &inet;
+		length = sizeof(inet);
+	}
+	else
+	{
+		if (address.size() >= sizeof(local.sun_path))
+			return -1;
+		memset(&local, 0, sizeof(local));
+		local.sun_family = AF_UNIX;
+		memcpy(local.sun_path, address.c_str(), address.size());
+		name = (sockaddr *) &local;
+		length = sizeof(local);
+	}
+
+	int fd = socket(tcp ? AF_INET : AF_UNIX, SOCK_STREAM, 0);
+	if (fd < 0)
+		return -1;
+	int on = 1;
+	bool ready;
+	if (listening)
+	{
+		if (tcp)
+			setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+		else
+			unlink(address.c_str());
+		ready = bind(fd, name, length) == 0 && listen(fd, SOMAXCONN) == 0;
+	}
+	else
+	{
+		ready = connect(fd, name, length) == 0;
+		if (tcp)
+			setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+	}
+	if (!ready)
+	{
+		close(fd);
+		return -1;
+	}
+	return fd;
+}
+
+//=================================================================
+
+/**
+ * class LoadGenerator - client of an allocator started with --serve. Opens
+ * connections from as many threads, and every thread sends its commands in
+ * batches of pipeline RQ and RL, ended by PING, and waits for the PONG that
+ * tells the batch was run. Reports the throughput and the round trip latency
+ * of the batches.
+ */
+class LoadGenerator
+{
+private:
+	//instance data, load configuration
+	int connections;
+	int pipeline;
+	long commands;    //per connection
+	int liveTarget;   //processes a connection keeps before it releases as often as it requests
+	bool binary;      //batches go as binary frames instead of text lines
+
+	/*
+	 * drive - runs the commands of connection id over fd, recording the round
+	 * trip of every batch in latency. rejected counts the commands the server
+	 * turned down, the reply lines other than PONG or the negative results.
+	 */
+	void drive(int id, int fd, LatencyRecorder & latency, long & rejected)
+	{
+		std::mt19937_64 random(id + 1);
+		std::uniform_int_distribution<int> sizes(16, 4096);
+		std::vector<long> live;     //numbers of the processes requested and not released
+		std::vector<long> unused;   //numbers released, reused so the names stay few like real ids
+		long counter = 0;
+		std::string batch;
+		std::vector<WireOp> ops;
+		char block[65536];
+		rejected = 0;
+		for (long sent = 0; sent < commands; )
+		{
+			//one batch of requests and releases, ended by PING or framed
+			batch.clear();
+			ops.clear();
+			for (int k = 0; k < pipeline && sent < commands; k++, sent++)
+			{
+				WireOp op;
+				memset(&op, 0, sizeof(op));
+				if (live.empty() || ((int) live.size() < liveTarget ? random() % 4 != 0 : random() % 2 == 0))
+				{
+					if (unused.empty())
+						live.push_back(counter++);
+					else
+					{
+						live.push_back(unused.back());
+						unused.pop_back();
+					}
+					op.op = 'R';
+					op.strategy = 'B';
+					op.size = sizes(random);
+				}
+				else
+				{
+					std::size_t victim = random() % live.size();
+					std::swap(live[victim], live.back());
+					op.op = 'L';
+				}
+				if (binary)
+				{
+					op.id = (int) ((live.back() * connections + id) % wireIds);
+					ops.push_back(op);
+				}
+				else if (op.op == 'R')
+					batch += "RQ C" + std::to_string(id) + "." + std::to_string(live.back()) + " " + std::to_string(op.size) + " B\n";
+				else
+					batch += "RL C" + std::to_string(id) + "." + std::to_string(live.back()) + "\n";
+				if (op.op == 'L')
+				{
+					unused.push_back(live.back());
+					live.pop_back();
+				}
+			}
+			std::size_t replyBytes = 0;
+			if (binary)
+			{
+				WireHeader header;
+				memcpy(header.magic, wireRequest, sizeof(header.magic));
+				header.count = (int) ops.size();
+				batch.append((const char *) &header, sizeof(header));
+				batch.append((const char *) ops.data(), ops.size() * sizeof(WireOp));
+				replyBytes = sizeof(header) + ops.size() * sizeof(Address);
+			}
+			else
+				batch += "PING\n";
+
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			const char * cursor = batch.data();
+			const char * end = cursor + batch.size();
+			while (cursor < end)
+			{
+				ssize_t written = write(fd, cursor, end - cursor);
+				if (written <= 0)
+					return;
+				cursor += written;
+			}
+
+			//replies end with the PONG of the batch, or are one reply frame
+			std::string replies;
+			while (binary ? replies.size() < replyBytes
+					: replies.size() < 5 || replies.compare(replies.size() - 5, 5, "PONG\n") != 0)
+			{
+				ssize_t bytes = read(fd, block, sizeof(block));
+				if (bytes <= 0)
+					return;
+				replies.append(block, bytes);
+			}
+			latency.record((long) std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+			if (!binary)
+				rejected += std::count(replies.begin(), replies.end(), '\n') - 1;
+			for (std::size_t i = 0; binary && i < ops.size(); i++)
+			{
+				Address result;
+				memcpy(&result, &replies[sizeof(WireHeader) + i * sizeof(Address)], sizeof(result));
+				if (result < 0)
+					rejected++;
+			}
+		}
+	}
+
+public:
+	/**
+	 * LoadGenerator constructor - 4 connections of 100000 commands in batches of 64
+	 */
+	LoadGenerator()
+	{
+		connections = 4;
+		pipeline = 64;
+		commands = 100000;
+		liveTarget = 1000;
+		binary = false;
+	}
+
+	/**
+	 * parseOption - consumes the load generator option at values[i] and its value.
+	 * Returns false case the option is not a load generator option or its value is invalid.
+	 * 		--connections <n>   --pipeline <n>   --commands <n>   --binary
+	 */
+	bool parseOption(int & i, int count, char ** values)
+	{
+		if (strcmp(values[i], "--binary") == 0)
+		{
+			binary = true;
+			return true;
+		}
+		if (i + 1 >= count)
+			return false;
+		std::string option = values[i];
+		long value = atol(values[i + 1]);
+		if (value <= 0)
+			return false;
+		if (option == "--connections")
+			connections = (int) value;
+		else if (option == "--pipeline")
+			pipeline = (int) value;
+		else if (option == "--commands")
+			commands = value;
+		else
+			return false;
+		i++;
+		return true;
+	}
+
+	/**
+	 * run - drives the allocator listening on address and prints the report to
+	 * out. Returns -1 case a connection can not be opened.
+	 */
+	int run(const std::string & address, std::ostream & out)
+	{
+		std::vector<int> fds;
+		for (int c = 0; c < connections; c++)
+		{
+			int fd = openSocket(address, false);
+			if (fd < 0)
+			{
+				out << "\nERROR: Could not connect to " << address << "\n";
+				for (std::size_t i = 0; i < fds.size(); i++)
+					close(fds[i]);
+				return -1;
+			}
+			fds.push_back(fd);
+		}
+
+		std::vector<LatencyRecorder> latency(connections);
+		std::vector<long> rejected(connections, 0);
+		std::vector<std::thread> threads;
+		std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+		for (int c = 0; c < connections; c++)
+			threads.push_back(std::thread(&LoadGenerator::drive, this, c, fds[c], std::ref(latency[c]), std::ref(rejected[c])));
+		for (int c = 0; c < connections; c++)
+			threads[c].join();
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+		LatencyRecorder all;
+		long totalRejected = 0;
+		for (int c = 0; c < connections; c++)
+		{
+			all.merge(latency[c]);
+			totalRejected += rejected[c];
+			close(fds[c]);
+		}
+		long sent = (long) all.count() > 0 ? std::min((long) all.count() * pipeline, commands * connections) : 0;
+		out << "\nLoad generator: " << connections << " connections to " << address << ", " << commands
+				<< " commands each in " << (binary ? "binary" : "text") << " batches of " << pipeline << "\n\n";
+		char buffer[120];
+		sprintf(buffer, "%-26s %10s %10s %10s %10s", "Round trip (ns)", "count", "p50", "p99", "p999");
+		out << buffer << "\n" << all.toString("batch") << "\n\n";
+		out << "Throughput: " << (long) (sent / (seconds > 0 ? seconds : 1)) << " commands/sec ("
+				<< sent << " commands, " << totalRejected << " rejected, in " << seconds << " seconds)\n";
+		return 0;
+	}
+};
+
+//=================================================================
+
+/**
+ * class BufferedWriter - stream buffer that collects output in a large
+ * block and writes it to a file descriptor only when the block is full,
+ * on flush, or when destroyed. Used by the batch modes so replies do not
+ * pay for one write per command.
+ */
+class BufferedWriter : public std::streambuf
+{
+private:
+	int fd;
+	char * buffer;
+	std::size_t capacity;
+
+	/*
+	 * writeOut - writes the pending bytes to the file descriptor and resets the buffer
+	 */
+	bool writeOut()
+	{
+		char * start = pbase();
+		while (start < pptr())
+		{
+			ssize_t written = write(fd, start, pptr() - start);
+			if (written <= 0)
+				return false;
+			start += written;
+		}
+		setp(buffer, buffer + capacity);
+		return true;
+	}
+
+protected:
+	int overflow(int c)
+	{
+		if (!writeOut())
+			return traits_type::eof();
+		if (c != traits_type::eof())
+		{
+			*pptr() = (char) c;
+			pbump(1);
+		}
+		return traits_type::not_eof(c);
+	}
+
+	int sync()
+	{
+		return writeOut() ? 0 : -1;
+	}
+
+public:
+	/**
+	 * BufferedWriter constructor - writes to descriptor f through a buffer of size bytes
+	 */
+	BufferedWriter(int f, std::size_t size)
+	{
+		fd = f;
+		capacity = size;
+		buffer = new char[capacity];
+		setp(buffer, buffer + capacity);
+	}
+
+	~BufferedWriter()
+	{
+		writeOut();
+		delete [] buffer;
+	}
+};
+
+/**
+ * class StringSink - stream buffer that appends output to a string. Used by
+ * the server to collect the replies of a connection until it can take them.
+ */
+class StringSink : public std::streambuf
+{
+private:
+	std::string & target;
+
+protected:
+	int overflow(int c)
+	{
+		if (c != traits_type::eof())
+			target.push_back((char) c);
+		return traits_type::not_eof(c);
+	}
+
+	std::streamsize xsputn(const char * s, std::streamsize n)
+	{
+		target.append(s, n);
+		return n;
+	}
+
+public:
+	/**
+	 * StringSink constructor - appends to t
+	 */
+	StringSink(std::string & t) : target(t)
+	{
+	}
+};
+
+//=================================================================
+
+/**
+ * class WriteAheadLog - append-only log of the commands that change a memory,
+ * RQ and RS with the place they got, RL and every kind of compaction, so the memory
+ * survives a crash. Records are collected in a buffer and written with one
+ * write and one fdatasync per group, on commit or when the buffer is full.
+ * Every checkpointEvery commands the memory is saved as a snapshot next to the
+ * log, file.snap, and the log starts over. Case checkpointEvery is 0 that happens
+ * once the log is larger than the last snapshot, at least 16MB, so replaying the
+ * log never costs much more than loading the snapshot. Recovery loads the snapshot and
+ * replays only the commands logged after it, up to the first record cut short
+ * or failing its CRC-32. Records and snapshots carry the
+ * sequence number of the command, so a crash between the snapshot and the
+ * truncation of the log replays nothing twice. Once a write or a sync fails the
+ * log is broken for good, what the disk holds is not known, and every later
+ * commit fails so the caller stops taking commands.
+ */
+class WriteAheadLog
+{
+private:
+	/*
+	 * LogRecord - a logged command, followed by nameBytes bytes of the process name
+	 */
+	struct LogRecord
+	{
+		Address sequence;
+		Address firstByte;    //first byte given to RQ or RS, last byte of memory for C
+		Address size;         //bytes of RQ or RS, budget of C STEP
+		int op;               //'R' request, 'L' release, 'Z' resize, 'C' compact, 'P' planned compact, 'S' compaction step
+		int nameBytes;
+		unsigned int crc;     //CRC-32 of the fields above and the name, see checksum
+		int unused;           //zero, keeps the size free of padding
+	};
+
+	/*
+	 * CrcTable - CRC-32 of every byte value, for the polynomial of zlib and Ethernet
+	 */
+	struct CrcTable
+	{
+		unsigned int entry[256];
+
+		CrcTable()
+		{
+			for (unsigned int n = 0; n < 256; n++)
+			{
+				unsigned int c = n;
+				for (int k = 0; k < 8; k++)
+					c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+				entry[n] = c;
+			}
+		}
+	};
+
+	static const std::size_t groupBytes = 1 << 20;
+	static const Address automaticBytes = 16 << 20;
+
+	std::string file;
+	std::string checkpointFile;
+	int fd;
+	std::string pending;       //records not written yet
+	bool broken;               //a write or a sync failed
+	Address sequence;          //sequence number of the last command logged
+	long checkpointEvery;
+	long sinceCheckpoint;
+	Address logBytes;          //bytes logged since the last checkpoint
+	Address checkpointBytes;   //size of the last snapshot
+
+	/*
+	 * checksum - returns the CRC-32 of the fields of record before crc and of name
+	 */
+	static unsigned int checksum(const LogRecord & record, std::string_view name)
+	{
+		static const CrcTable table;
+		unsigned int crc = 0xFFFFFFFFu;
+		const unsigned char * bytes = (const unsigned char *) &record;
+		for (std::size_t i = 0; i < offsetof(LogRecord, crc); i++)
+			crc = table.entry[(crc ^ bytes[i]) & 0xFF] ^ (crc >> 8);
+		for (std::size_t i = 0; i < name.size(); i++)
+			crc = table.entry[(crc ^ (unsigned char) name[i]) & 0xFF] ^ (crc >> 8);
+		return ~crc;
+	}
+
+	/*
+	 * syncDirectory - waits until the entries of the directory holding the log
+	 * are on disk, so a rename or a new file survives a crash. Returns false case it fails.
+	 */
+	bool syncDirectory()
+	{
+		std::size_t slash = file.rfind('/');
+		std::string directory = (slash == std::string::npos) ? "." : (slash == 0) ? "/" : file.substr(0, slash);
+		int handle = open(directory.c_str(), O_RDONLY | O_DIRECTORY);
+		if (handle < 0)
+			return false;
+		bool synced = fsync(handle) == 0;
+		close(handle);
+		return synced;
+	}
+
+	/*
+	 * apply - runs the logged command record against memory. Returns false
+	 * case it can not be run as it was, the log does not match the memory.
+	 */
+	static bool apply(const LogRecord & record, std::string_view name, Memory & memory)
+	{
+		int regions = 0;
+		switch (record.op)
+		{
+		case 'R':
+			return memory.addProcessAt(name, record.size, record.firstByte);
+		case 'L':
+			return memory.removeProcessFromMemory(name);
+		case 'C':
+			memory.compactMemory(record.firstByte);
+			return true;
+		case 'P':
+			memory.compactMemoryPlanned();
+			return true;
+		case 'S':
+			memory.compactMemoryStep(record.size, regions);
+			return true;
+		case 'Z':
+		{
+			bool inPlace = false;
+			return memory.resizeProcess(name, record.size, inPlace) == record.firstByte;
+		}
+		default:
+			return false;
+		}
+	}
+
+	//disable copies, the file is owned by one log
+	WriteAheadLog(const WriteAheadLog &);
+	WriteAheadLog & operator=(const WriteAheadLog &);
+
+public:
+	/**
+	 * WriteAheadLog constructor - log in file f, with a checkpoint every n commands,
+	 * or as large as the log gets case n is 0. Nothing is opened until recover is called.
+	 */
+	WriteAheadLog(const std::string & f, long n)
+	{
+		file = f;
+		checkpointFile = f + ".snap";
+		fd = -1;
+		broken = false;
+		sequence = 0;
+		checkpointEvery = n;
+		sinceCheckpoint = 0;
+		logBytes = 0;
+		checkpointBytes = 0;
+	}
+
+	/**
+	 * WriteAheadLog destructor - commits what is pending and closes the log
+	 */
+	~WriteAheadLog()
+	{
+		if (fd >= 0)
+		{
+			commit();
+			close(fd);
+		}
+	}
+
+	/**
+	 * recover - loads the last checkpoint, if any, into the empty memory, replays
+	 * the commands logged after it and opens the log to append. A record cut
+	 * short by a crash or whose checksum does not match ends the log and is dropped. replayed is set to the
+	 * commands replayed. Returns false case the checkpoint or the log can not be
+	 * read or do not match the memory.
+	 */
+	bool recover(Memory & memory, long & replayed)
+	{
+		replayed = 0;
+		Address covered = 0;
+		if (access(checkpointFile.c_str(), F_OK) == 0 && !memory.load(checkpointFile, covered))
+			return false;
+		sequence = covered;
+
+		//read the whole log, it only holds the commands since the last checkpoint
+		std::string log;
+		int input = open(file.c_str(), O_RDONLY);
+		if (input >= 0)
+		{
+			char block[65536];
+			ssize_t bytes;
+			while ((bytes = read(input, block, sizeof(block))) > 0)
+				log.append(block, bytes);
+			close(input);
+		}
+
+		std::size_t offset = 0;
+		while (offset + sizeof(LogRecord) <= log.size())
+		{
+			LogRecord record;
+			memcpy(&record, log.data() + offset, sizeof(record));
+			if (record.nameBytes < 0 || offset + sizeof(record) + record.nameBytes > log.size())
+				break;
+			std::string_view name(log.data() + offset + sizeof(record), record.nameBytes);
+			if (record.crc != checksum(record, name))
+				break;
+
+			//case the record is newer than the checkpoint and than every record applied
+			if (record.sequence > sequence)
+			{
+				if (!apply(record, name, memory))
+					return false;
+				replayed++;
+				sinceCheckpoint++;
+				sequence = record.sequence;
+			}
+			offset += sizeof(record) + record.nameBytes;
+		}
+
+		logBytes = offset;
+		int snapshot = open(checkpointFile.c_str(), O_RDONLY);
+		if (snapshot >= 0)
+		{
+			checkpointBytes = lseek(snapshot, 0, SEEK_END);
+			close(snapshot);
+		}
+		fd = open(file.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+		return fd >= 0 && ftruncate(fd, offset) == 0 && syncDirectory();
+	}
+
+	/**
+	 * append - logs a command that changed the memory, see LogRecord. It is
+	 * durable once the group it is in is committed.
+	 */
+	void append(char op, std::string_view name, Address firstByte, Address size)
+	{
+		LogRecord record = { ++sequence, firstByte, size, op, (int) name.size(), 0, 0 };
+		record.crc = checksum(record, name);
+		pending.append((const char *) &record, sizeof(record));
+		pending.append(name.data(), name.size());
+		sinceCheckpoint++;
+		logBytes += sizeof(record) + name.size();
+		if (pending.size() >= groupBytes)
+			commit();
+	}
+
+	/**
+	 * commit - writes the pending records and waits until they are on disk.
+	 * Returns false case writing or syncing fails, now or in an earlier commit.
+	 * What was written is taken out of the pending records, so nothing is
+	 * written twice.
+	 */
+	bool commit()
+	{
+		if (broken)
+			return false;
+		if (pending.empty())
+			return true;
+		std::size_t start = 0;
+		while (start < pending.size())
+		{
+			ssize_t written = write(fd, pending.data() + start, pending.size() - start);
+			if (written < 0 && errno == EINTR)
+				continue;
+			if (written <= 0)
+			{
+				pending.erase(0, start);
+				broken = true;
+				return false;
+			}
+			start += written;
+		}
+		pending.clear();
+		broken = fdatasync(fd) != 0;
+		return !broken;
+	}
+
+	/**
+	 * checkpointDue - returns true case checkpointEvery commands were logged since
+	 * the last checkpoint, or case it is 0, the log outgrew the last snapshot
+	 */
+	bool checkpointDue()
+	{
+		if (checkpointEvery > 0)
+			return sinceCheckpoint >= checkpointEvery;
+		return logBytes >= automaticBytes && logBytes >= checkpointBytes;
+	}
+
+	/**
+	 * checkpoint - saves memory as the snapshot of every command logged so far
+	 * and starts the log over. The snapshot is written next to the old one and
+	 * renamed over it, so a crash leaves one of them whole. The directory is
+	 * synced before the log is truncated, so the truncation never outlives the
+	 * rename. Returns false case
+	 * the snapshot can not be written, the log is kept then.
+	 */
+	bool checkpoint(Memory & memory)
+	{
+		if (!commit())
+			return false;
+		std::string next = checkpointFile + ".tmp";
+		if (!memory.save(next, sequence))
+			return false;
+		int written = open(next.c_str(), O_RDONLY);
+		bool synced = written >= 0 && fsync(written) == 0;
+		if (written >= 0)
+		{
+			checkpointBytes = lseek(written, 0, SEEK_END);
+			close(written);
+		}
+		if (!synced || rename(next.c_str(), checkpointFile.c_str()) != 0 || !syncDirectory())
+			return false;
+		sinceCheckpoint = 0;
+		logBytes = 0;
+		return ftruncate(fd, 0) == 0;
+	}
+};
+
+//=================================================================
+
+/**
+ * class Allocator - Defines the behavior of a memory allocator app
+ */ 
+class Allocator
+{
+private:
+	//instance data, batch mode options
+	std::string replayFile;
+	bool batchMode;
+
+	//socket the server listens on and the server a load generator drives, empty when not used
+	std::string serveAddress;
+	std::string clientAddress;
+	LoadGenerator loadGenerator;
+	std::vector<WireOp> batch;     //operations and results of the binary batch being served
+	std::vector<Address> batchResults;
+
+	//memory backed by a real arena
+	bool arenaMode;
+
+	//small requests served from size class slabs
+	bool slabMode;
+
+	//zone bytes for requests with strategy U, 0 when buddy allocation is off
+	int buddyZoneBytes;
+
+	//bytes moved by incremental compaction between commands, 0 when disabled
+	long autoCompactBudget;
+
+	//shards the address space is split in, 0 when it is not split
+	int shardCount;
+
+	//snapshot loaded at startup, empty when memory starts empty
+	std::string loadFile;
+
+	//write-ahead log of the commands and commands between its checkpoints, 0 to go by log size. NULL when not logging
+	std::string walFile;
+	long checkpointEvery;
+	WriteAheadLog * wal;
+
+	//largest memory accepted, 1EB
+	static const Address maxMemory = 1LL << 60;
+
+	//smallest shard --shards may split the memory in
+	static const Address minimumShard = 4096;
+
+	//benchmark mode and its workload
+	bool benchMode;
+	Benchmark benchmark;
+
+	/*
+	 * Opcode - command named by the first word of an input line
+	 */
+	enum Opcode { OP_RQ, OP_RL, OP_RS, OP_STAT, OP_METRICS, OP_C, OP_SAVE, OP_PING, OP_QUIT, OP_HELP, OP_INVALID };
+
+	/*
+	 * Command - an input line split in up to four words. Words are views into
+	 * the line, so the line must outlive the command. Missing words are empty.
+	 */
+	struct Command
+	{
+		Opcode opcode;
+		std::string_view word[4];
+	};
+
+	//bytes read from one client per wakeup, replies held for one client before reading stops, longest line
+	static const std::size_t readBudget = 256 << 10;
+	static const std::size_t outputLimit = 1 << 20;
+	static const std::size_t lineLimit = 4096;
+
+	/*
+	 * Connection - a client of the server with the bytes it sent that do not
+	 * make a whole line yet and the replies it did not take yet
+	 */
+	struct Connection
+	{
+		int fd;
+		std::string input;
+		std::string output;
+		bool closing;     //sent QUIT or hung up, closed once output is written
+	};
+
+	/*
+	 * opcodeOf - returns the opcode named by word, switching on its length and,
+	 * for four letter words, on the first letter, so every command is told apart
+	 * with at most three comparisons
+	 */
+	static Opcode opcodeOf(std::string_view word)
+	{
+		switch (word.size())
+		{
+		case 1:
+			return word[0] == 'C' ? OP_C : OP_INVALID;
+		case 2:
+			if (word == "RQ")
+				return OP_RQ;
+			if (word == "RL")
+				return OP_RL;
+			return word == "RS" ? OP_RS : OP_INVALID;
+		case 4:
+			switch (word[0])
+			{
+			case 'S':
+				if (word == "STAT")
+					return OP_STAT;
+				return word == "SAVE" ? OP_SAVE : OP_INVALID;
+			case 'Q':
+				return word == "QUIT" ? OP_QUIT : OP_INVALID;
+			case 'P':
+				return word == "PING" ? OP_PING : OP_INVALID;
+			case 'H':
+				return word == "HELP" ? OP_HELP : OP_INVALID;
+			default:
+				return OP_INVALID;
+			}
+		case 7:
+			return word == "METRICS" ? OP_METRICS : OP_INVALID;
+		default:
+			return OP_INVALID;
+		}
+	}
+
+	/*
+	 * parseNumber - parses the decimal number at the start of word into value,
+	 * ignoring what follows it, like stoi. Returns false case word does not
+	 * start with a number or the number does not fit in value.
+	 */
+	template <class Integer>
+	static bool parseNumber(std::string_view word, Integer & value)
+	{
+		//from_chars takes no plus sign
+		if (!word.empty() && word[0] == '+')
+		{
+			word.remove_prefix(1);
+			if (!word.empty() && word[0] == '-')
+				return false;
+		}
+		return std::from_chars(word.data(), word.data() + word.size(), value).ec == std::errc();
+	}
+
+	/**
+	 * parseUserInput - Process and validates a line of input from
+	 * the user. Returns the command with the words entered by 
+	 * the user. Trims spaces and tabs from beginning, end, and multiple spaces between commands.
+	 * Also trims tabs. Best to have no spaces in beginning and end, and just
+	 * a space between words in same command. Words are views into userInput,
+	 * so no memory is allocated. QUIT, HELP, PING and METRICS keep one word, RL and SAVE two words,
+	 * RS three words and any other command up to four.
+	 */ 
+	Command parseUserInput(std::string_view userInput)
+	{
+		Command command;
+		command.opcode = OP_INVALID;
+		std::size_t place = 0;
+		std::size_t words = 4;
+		for (std::size_t i = 0; i < words; i++)
+		{
+			//skip multiple spaces between entries
+			while (place < userInput.size() && (userInput[place] == ' ' || userInput[place] == '\t'))
+				place++;
+
+			//get the entry
+			std::size_t start = place;
+			while (place < userInput.size() && userInput[place] != ' ' && userInput[place] != '\t')
+				place++;
+			command.word[i] = userInput.substr(start, place - start);
+
+			//the first entry tells how many entries the command has
+			if (i == 0)
+			{
+				command.opcode = opcodeOf(command.word[0]);
+				if (command.opcode == OP_QUIT || command.opcode == OP_HELP || command.opcode == OP_PING || command.opcode == OP_METRICS)
+					words = 1;
+				else if (command.opcode == OP_RL || command.opcode == OP_SAVE)
+					words = 2;
+				else if (command.opcode == OP_RS)
+					words = 3;
+			}
+		}
+		return command;
+	}
+
+	/**
+	 * printUsage - returns a string with usage contents for the user. This can be accessed 
+	 * during app execution with -help argument or by entering HELP to allocator>  during
+	 * the program runtime, which does not halt the execution.
+	 */ 
+	std::string printUsage()
+	{
+		std::stringstream ss;
+		ss <<
+				"\n	This project simulates a linear memory allocator application. The memory is initially\n" <<
+				"	set to have its first byte at location 0 and last available memory byte is \n" <<
+				"	represented by the integer passed as program argument during execution, minus 1. When \n" <<
+				"	the program loads, the user sees the prompt 'allocator >' to which the user can\n" <<
+				"	input commands like the following space separated or tab separated example commands in a line:\n\n" <<
+				"	a. RQ P3 1024 B	Requests memory for P3 using best fit strategy for 1024 bytes allocation.\n" <<
+				"			Case there is not enough memory, user is warned, and request is rejected.\n" <<
+				"			Other strategies are F first fit, N next fit, W worst fit and U buddy.\n\n" <<
+				"	b. RL P3	Releases the memory allocated to P3.\n" <<
+				"			Case P3 is not a valid allocated process name, the user is warned and release command is rejected.\n\n" <<
+				"	   RS P3 2048	Resizes P3 to 2048 bytes, in place case it shrinks or the bytes after it are free, otherwise\n" <<
+				"			it moves to the best fit gap. Prints whether it moved. Processes in slabs or buddy zones can not be resized.\n\n" <<
+				"	c. STAT		Prints status of memory, start and final byte, and process name or FREE if memory is not allocated .\n\n" <<
+				"	   STAT SHARD 2	Prints the status of shard 2 only, with --shards.\n\n" <<
+				"	   STAT 0 4095	Prints only the processes and free gaps holding bytes 0 to 4095.\n\n" <<
+				"	   STAT JSON	Prints the status as one JSON object per line. Also STAT 0 4095 JSON and STAT SHARD 2 JSON.\n\n" <<
+				"	   METRICS	Prints the bytes used and free, the regions, free gaps and largest free block, the external\n" <<
+				"			fragmentation, the allocations, failed allocations and releases and the resizes and those done in place so far, without walking memory.\n\n" <<
+				"	d. C		Compacts the memory by shifting free space towards the higher bytes in memory.\n\n" <<
+				"	   C STEP 4096	Compacts incrementally, moving about 4096 bytes per step. Commands keep working between steps.\n\n" <<
+				"	   C PLAN	Compacts moving as few bytes as possible, filling gaps with processes from the top of memory.\n" <<
+				"			Prints the bytes and processes moved next to what C would move.\n\n" <<
+				"	   C SHARD 2	Compacts shard 2 only, with --shards. The other shards are not blocked.\n\n" <<
+				"	   C BACKGROUND	Compacts on a worker thread, commands and STAT keep working on the current layout. The compacted\n" <<
+				"			layout is swapped in at the first command after it is built, printing the swap pause. Processes\n" <<
+				"			requested meanwhile move right after the compacted ones. Does not combine with --wal or --shards.\n\n" <<
+				"	   C WAIT	Waits for the background compaction and swaps it in.\n\n" <<
+				"	e. QUIT		Quits the program.\n\n" <<
+				"	f. HELP		Prints program usage during runtime, program does not quit.\n\n" <<
+				"	g. SAVE heap.snap	Saves the processes and their names in the binary snapshot file heap.snap, which --load\n" <<
+				"			maps at startup. Memory with --slabs, --buddy or --shards can not be saved.\n\n" <<
+				"	h. PING		Replies PONG. Clients of --serve end a pipelined batch with it, RQ and RL reply nothing case they succeed.\n\n" <<
+				"	Note: All commands are case sensitive and should not contain spaces in the beginning or \n" <<
+				"	      end of input line for guaranteed execution. The strategy options are B best fit, F first fit, N next fit, W worst fit\n" <<
+				"	      and U buddy, with --buddy, any other value passed for the fourth item of RQ will cause allocation to be rejected. Multiple space and tab trimming\n" <<
+				"	      for input line was implemented, but single space separation between entries in the line is still preferred for optimal execution.\n\n" <<
+				"	Usage:  Instruction for how to run the program:\n" <<
+				"			g++ -c allocator_VMachado.cpp          Compiles the source code in to object file\n" <<
+				"			g++ -c VMapp.exe allocator_VMachado.o  Links the object file to executable.\n" <<
+				"			./VMapp.exe 1048576                    Runs and allocates 1MB for the allocator app.\n" <<
+				"			./VMapp.exe -help                      Prints usage information\n" <<
+				"			./VMapp.exe 1048576 --replay trace.txt Replays the commands in trace.txt without prompts.\n" <<
+				"			./VMapp.exe 1048576 --pipe < trace.txt Replays the commands piped to standard input without prompts.\n" <<
+				"			PS: Batch modes buffer all output and print the throughput in commands per second at the end.\n" <<
+				"			./VMapp.exe 1048576 --bench            Runs the synthetic benchmark and prints latency percentiles.\n" <<
+				"			PS: Benchmark options are --dist uniform|powerlaw|bimodal, --release lifo|fifo|random,\n" <<
+				"			    --occupancy <0..1>, --ops <n>, --min <bytes>, --max <bytes>, --seed <n> and\n" <<
+				"			    --step <bytes> to take an incremental compaction step between operations,\n" <<
+				"			    --compact slide|plan to compact like C or like C PLAN, --fit B|F|N|W|U for the strategy,\n" <<
+				"			    --threads <n> to measure the concurrent allocator with 1, 2, 4, ... up to n worker threads,\n" <<
+				"			    --extents <n> to compare best fit in the SIMD extent table and in the list for 256, 1024, ... up to n processes.\n" <<
+				"			./VMapp.exe 1048576 --arena            Backs the memory with a real arena. RQ prints the handle of\n" <<
+				"			    the process bytes and C moves the bytes and prints the bandwidth. Works with --bench too.\n" <<
+				"			./VMapp.exe 1048576 --auto-compact 4096 Runs a compaction step of about 4096 bytes after every command.\n" <<
+				"			./VMapp.exe 1048576 --slabs            Serves requests up to 2048 bytes from 64KB slabs of power of two\n" <<
+				"			    size classes. STAT shows the slabs, the processes in them and the slab hit rate.\n" <<
+				"			./VMapp.exe 1048576 --buddy 262144     Serves RQ with strategy U from buddy zones of 262144 bytes. STAT shows\n" <<
+				"			    the blocks of every zone and the internal fragmentation.\n" <<
+				"			./VMapp.exe 1048576 --shards 4         Splits the memory in 4 shards with their own process lists and locks. RQ goes\n" <<
+				"			    to the shard picked by the name, or to the next shard with room case it is full. STAT shows\n" <<
+				"			    every shard. Shards hold at least 4096 bytes. Does not combine with --arena or --bench.\n" <<
+				"			./VMapp.exe 1048576 --load heap.snap   Starts with the processes saved by SAVE in heap.snap, mapped and\n" <<
+				"			    loaded with no parsing. The memory must hold every process. Does not combine with --shards.\n" <<
+				"			./VMapp.exe 1048576 --wal heap.log     Logs RQ, RL, RS and C in heap.log, with a checkpoint in heap.log.snap once the log\n" <<
+				"			    outgrows it, or every n commands with --checkpoint <n>. At startup the checkpoint is loaded and the\n" <<
+				"			    log replayed, so a crashed allocator comes back where it was. Does not combine with --slabs, --buddy,\n" <<
+				"			    --shards, --arena, --load or --bench.\n" <<
+				"			./VMapp.exe 1048576 --serve 7000       Serves the commands of many clients on localhost TCP port 7000, or on a Unix\n" <<
+				"			    socket when the value is a path, from one epoll thread. Clients may pipeline commands and replies\n" <<
+				"			    come back in order. Between lines a client may send binary batches of RQ and RL with numeric ids,\n" <<
+				"			    answered with one array of results, see WireOp. A line over 4096 bytes closes the client, QUIT closes\n" <<
+				"			    the client only, Ctrl-C stops the server.\n" <<
+				"			./VMapp.exe 1048576 --client 7000      Drives the server on port 7000 and prints the throughput and the\n" <<
+				"			    round trip percentiles. Options are --connections <n>, --pipeline <n> commands per batch and\n" <<
+				"			    --commands <n> per connection, and --binary to send binary batches. The memory size is not used.\n\n" <<
+				"			PS: 1MB is lowest value allowed and will get overwritten to 1048576. Any value\n" <<
+				"			    over 1048576 will extend memory allocation, up to 1152921504606846976, or 1EB.\n\n" <<
+				"	Memory slot range: [ 0      :   argv[1] - 1 ] \n\n"  <<
+				"	Where argv[1] is argument passed when executing the program and \n" <<
+				"	which lowest value can be 1048576, representing 1MB.\n\n";
+		return ss.str();
+	}
+
+	/**
+	 * validateArguments - validates the arguments passed in by the user 
+	 * when executing the program. Possible arguments are -help for the 
+	 * usage information OR a integer greater than 1048576 as the high
+	 * byte for the memory cluster. Any value lower to this will default to 1048576
+	 * while any value greater than it will extend memory available for allocation.
 	 */ 
-	bool removeProcessFromMemory(std::string procName)
+	Address validateArguments(int count, char ** values)
+	{
+		//no argument passed. I guess i could also default to 1048576, user should read info!
+		if(count == 1)
+			return -1;
+
+		//usage information
+		else if(strcmp(values[1], "-help") == 0)
+			return -2;
+
+		//attempt to parse argument as integer and catch exception case it fails
+		else
+		{
+			Address input = 0;
+			try
+			{
+				input = stoll(std::string(values[1]));
+			}
+			//if the value passed is not -help nor an integer, error occurs. Halt. Houston, we have a problem!
+			catch(const std::logic_error &x)
+			{
+				std::cout << "\nERROR: Argument must be an integer or -help. Low values default to 1048576, or 1MB\n";
+				std::cout << "        ***  " << x.what() << "  ***\n";
+				return -1;
+			}
+			//addresses and sizes are summed, so memory stays well below the largest 64 bit value
+			if(input > maxMemory)
+			{
+				std::cout << "\nERROR: Argument can not be larger than " << maxMemory << " bytes, or 1EB\n";
+				return -1;
+			}
+			if(input > 1048576)
+				return input;
+		}
+		return 1048576;
+	}
+
+	/**
+	 * parseOptions - reads the options following the memory size argument.
+	 * 		--replay <file>   replays the commands in file without prompts
+	 * 		--pipe            reads the commands from standard input without prompts
+	 * 		--arena           backs the memory with a real arena, see Memory
+	 * 		--slabs           serves small requests from size class slabs, see SizeClasses
+	 * 		--buddy <bytes>   serves requests with strategy U from buddy zones of bytes, see BuddyZones
+	 * 		--auto-compact <bytes>   runs a compaction step of about bytes after every command
+	 * 		--shards <n>      splits the address space in n shards, see Memory::enableShards
+	 * 		--load <file>     starts with the processes saved in file by SAVE, see Memory::load
+	 * 		--wal <file>      logs the commands in file and recovers from it, see WriteAheadLog
+	 * 		--checkpoint <n>  saves a checkpoint of the memory every n logged commands, not by log size
+	 * 		--serve <port|path>   serves the commands of clients on a localhost TCP port or a Unix socket
+	 * 		--client <port|path>  drives a server, see LoadGenerator::parseOption for its options
+	 * 		--bench           runs the synthetic benchmark, see Benchmark::parseOption for its options
+	 * size is the memory size, it bounds the number of shards.
+	 * Returns false and warns the user case an option is unknown or incomplete.
+	 */
+	bool parseOptions(int count, char ** values, Address size)
 	{
-		int value = processes.removeProcessByNumber(procName, false);
-		if(value < 0)
+		for (int i = 2; i < count; i++)
+		{
+			if (strcmp(values[i], "--replay") == 0 && i + 1 < count)
+			{
+				replayFile = values[++i];
+				batchMode = true;
+			}
+			else if (strcmp(values[i], "--pipe") == 0)
+				batchMode = true;
+			else if (strcmp(values[i], "--arena") == 0)
+				arenaMode = true;
+			else if (strcmp(values[i], "--slabs") == 0)
+				slabMode = true;
+			else if (strcmp(values[i], "--buddy") == 0 && i + 1 < count && atoi(values[i + 1]) > 0)
+				buddyZoneBytes = atoi(values[++i]);
+			else if (strcmp(values[i], "--auto-compact") == 0 && i + 1 < count && atol(values[i + 1]) > 0)
+				autoCompactBudget = atol(values[++i]);
+			else if (strcmp(values[i], "--shards") == 0 && i + 1 < count && atoi(values[i + 1]) > 0)
+				shardCount = atoi(values[++i]);
+			else if (strcmp(values[i], "--load") == 0 && i + 1 < count)
+				loadFile = values[++i];
+			else if (strcmp(values[i], "--wal") == 0 && i + 1 < count)
+				walFile = values[++i];
+			else if (strcmp(values[i], "--checkpoint") == 0 && i + 1 < count && atol(values[i + 1]) > 0)
+				checkpointEvery = atol(values[++i]);
+			else if (strcmp(values[i], "--serve") == 0 && i + 1 < count)
+				serveAddress = values[++i];
+			else if (strcmp(values[i], "--client") == 0 && i + 1 < count)
+				clientAddress = values[++i];
+			else if (strcmp(values[i], "--bench") == 0)
+				benchMode = true;
+			else if (!loadGenerator.parseOption(i, count, values) && !benchmark.parseOption(i, count, values))
+			{
+				std::cout << "\nERROR: Unknown or incomplete option " << values[i] << ". See usage.\n";
+				return false;
+			}
+		}
+		if (benchMode && !benchmark.isValid())
+		{
+			std::cout << "\nERROR: Benchmark options out of range, --max must be at least --min. See usage.\n";
+			return false;
+		}
+		if (shardCount > 0 && shardCount > size / minimumShard)
+		{
+			std::cout << "\nERROR: --shards " << shardCount << " makes shards below " << minimumShard << " bytes, at most "
+					<< size / minimumShard << " shards fit in this memory. See usage.\n";
+			return false;
+		}
+		if (shardCount > 0 && (arenaMode || benchMode))
+		{
+			std::cout << "\nERROR: --shards does not combine with --arena or --bench. See usage.\n";
+			return false;
+		}
+		if (shardCount > 0 && !loadFile.empty())
+		{
+			std::cout << "\nERROR: --load does not combine with --shards. See usage.\n";
+			return false;
+		}
+		if (!walFile.empty() && (slabMode || buddyZoneBytes > 0 || shardCount > 0 || arenaMode || !loadFile.empty() || benchMode))
+		{
+			std::cout << "\nERROR: --wal does not combine with --slabs, --buddy, --shards, --arena, --load or --bench. See usage.\n";
+			return false;
+		}
+		if (!serveAddress.empty() && (batchMode || benchMode || !clientAddress.empty()))
+		{
+			std::cout << "\nERROR: --serve does not combine with --replay, --pipe, --bench or --client. See usage.\n";
 			return false;
+		}
 		return true;
 	}
 
-	/*
-	 * compactMemory - compacts the linear memory as defined in LinkedList class.
-	 * Moves processes towards low end of bytes and frees up space towards
-	 * the high bytes in memory. A method to a method is used ofr encapsulation.
+	/**
+	 * shardNumber - parses the shard number of the SHARD commands. Returns it, or
+	 * -1 after writing why the command is rejected to out.
+	 */
+	int shardNumber(std::string_view value, Memory & memory, std::ostream & out)
+	{
+		if (!memory.isSharded())
+		{
+			out << "Request rejected, SHARD needs the --shards startup option. Enter HELP for more information.\n";
+			return -1;
+		}
+		int shard = -1;
+		if (!parseNumber(value, shard) || shard < 0 || shard >= (int) memory.shardCount())
+		{
+			out << "Request rejected, SHARD needs a shard number from 0 to " << memory.shardCount() - 1
+					<< ". Enter HELP for more information.\n";
+			return -1;
+		}
+		return shard;
+	}
+
+	/**
+	 * writeSwap - writes what publishing a background compaction moved and how long commands waited
+	 */
+	void writeSwap(const Memory::CompactionSwap & swap, std::ostream & out)
+	{
+		if (swap.slid)
+			out << "Background compaction slid in place, the " << swap.arrivals << " processes added meanwhile did not fit after it. Moved "
+					<< swap.bytesMoved << " bytes";
+		else
+			out << "Background compaction published, moved " << swap.bytesMoved << " bytes in " << swap.regionsMoved
+					<< " processes and " << swap.arrivals << " processes added meanwhile";
+		out << ", built in " << swap.buildSeconds * 1e6 << " us, swap pause " << swap.pauseSeconds * 1e6 << " us\n";
+	}
+
+	/**
+	 * executeCommand - executes one parsed command against memory and writes the
+	 * reply, if any, to out. Shared by the interactive loop and the batch modes.
+	 * Returns true when the command is QUIT.
+	 */
+	bool executeCommand(const Command & command, Memory & memory, Address upperBound, std::ostream & out)
+	{
+		switch (command.opcode)
+		{
+		//case a memory request
+		case OP_RQ:
+		{
+			//buddy allocation must be enabled at startup
+			if(command.word[3] == "U" && !memory.isBuddyEnabled())
+				out << "Request rejected, strategy \'U\' needs the --buddy startup option. Enter HELP for more information.\n";
+
+			//must be a known strategy, best, first, next or worst fit, or buddy
+			else if(Memory::isStrategy(command.word[3]))
+			{
+				//attempt to parse third entry as integer, reject command if it fails.
+				Address size = 0;
+				bool error = !parseNumber(command.word[2], size);
+
+				//reject user command case process does not have an integer size
+				if(error || size <= 0)
+					out << "Request rejected, third parameter must be a positive integer. Enter HELP for more information.\n";
+
+				//case the memory is split, the name picks the home shard
+				else if (memory.isSharded())
+				{
+					if (!memory.addProcessToShards(command.word[1], size, command.word[3][0], std::hash<std::string_view>()(command.word[1])))
+					{
+						out << "There is not enough memory to load " << command.word[2] << " bytes. Enter HELP for more information.\n";
+					}
+				}
+
+				//otherwise attempt to allocate memory for request. If there is enough memory, memory is allocated
+				//else command is rejected and user is warned.
+				else
+				{
+					LinkedList::Slot slot = memory.findMemorySlot(size, command.word[3][0]);
+
+					//case not enough memory
+					if (slot.firstByte == -1)
+					{
+						out << "There is not enough memory to load " << command.word[2] << " bytes. Enter HELP for more information.\n";
+					}
+
+					//case there is a slot with enough memory, allocate. Arena memory reports the handle.
+					else
+					{
+						int handle = memory.addProcessToMemory(memory.newProcess(command.word[1], size), slot);
+						if (handle >= 0)
+							out << "Process " << command.word[1] << " handle " << handle << "\n";
+						if (wal != NULL)
+							wal->append('R', command.word[1], slot.firstByte, size);
+					}
+				}
+			}
+
+			// case the allocation strategy passed by the user is not known
+			else
+			{
+				out << "Invalid Parameter for Allocation Strategy, \'B\', \'F\', \'N\', \'W\' or \'U\' are the options. Enter HELP for more information.\n";
+			}
+			break;
+		}
+
+		//case user asks for help, usage information is printed
+		case OP_HELP:
+			out << printUsage();
+			break;
+
+		// case command is to release memory, attempt to release
+		case OP_RL:
+		{
+			bool done = memory.removeProcessFromMemory(command.word[1]);
+
+			//case process name does not exist, user is warned and command rejected
+			if(!done)
+				out << "Process does not exist. Enter HELP for more information.\n";
+			else if (wal != NULL)
+				wal->append('L', command.word[1], 0, 0);
+			break;
+		}
+
+		//case a process is to be resized, in place when the bytes after it are free
+		case OP_RS:
+		{
+			Address size = 0;
+			bool inPlace = false;
+			if (!parseNumber(command.word[2], size) || size <= 0)
+				out << "Request rejected, third parameter must be a positive integer. Enter HELP for more information.\n";
+			else if (memory.isCompacting())
+				out << "Request rejected, a background compaction is in flight. Enter C WAIT to publish it.\n";
+			else
+			{
+				Address first = memory.resizeProcess(command.word[1], size, inPlace);
+				if (first == -1)
+					out << "Process does not exist. Enter HELP for more information.\n";
+				else if (first == -2)
+					out << "There is not enough memory to resize to " << command.word[2] << " bytes. Enter HELP for more information.\n";
+				else if (first == -3)
+					out << "Request rejected, processes in slabs or buddy zones can not be resized. Enter HELP for more information.\n";
+				else
+				{
+					if (inPlace)
+						out << "Process " << command.word[1] << " resized in place\n";
+					else
+						out << "Process " << command.word[1] << " moved to byte " << first << "\n";
+					if (wal != NULL)
+						wal->append('Z', command.word[1], first, size);
+				}
+			}
+			break;
+		}
+
+		case OP_C:
+		{
+			//case memory is to be compacted on a worker thread, published by a later command
+			if (command.word[1] == "BACKGROUND")
+			{
+				if (wal != NULL)
+					out << "Request rejected, C BACKGROUND is not logged, it does not combine with --wal. Enter HELP for more information.\n";
+				else if (memory.isCompacting())
+					out << "Request rejected, a background compaction is in flight. Enter C WAIT to publish it.\n";
+				else if (!memory.startBackgroundCompaction())
+					out << "Request rejected, C BACKGROUND does not combine with --shards or could not reserve a new arena. Enter HELP for more information.\n";
+			}
+
+			//case the background compaction is to be published now
+			else if (command.word[1] == "WAIT")
+			{
+				Memory::CompactionSwap swap;
+				if (memory.publishCompaction(true, swap))
+					writeSwap(swap, out);
+				else
+					out << "No background compaction in flight.\n";
+			}
+
+			//other compactions move processes the worker is laying out
+			else if (memory.isCompacting())
+				out << "Request rejected, a background compaction is in flight. Enter C WAIT to publish it.\n";
+
+			//case memory is to be compacted in steps, report what the step moved
+			else if (command.word[1] == "STEP")
+			{
+				long budget = 0;
+				if (!parseNumber(command.word[2], budget) || budget <= 0)
+					out << "Request rejected, C STEP needs a positive number of bytes. Enter HELP for more information.\n";
+				else
+				{
+					int regions = 0;
+					long moved = memory.compactMemoryStep(budget, regions);
+					if (wal != NULL)
+						wal->append('S', "", 0, budget);
+					out << "Moved " << moved << " bytes in " << regions << " processes, compaction "
+							<< (memory.isCompacted() ? "complete" : "in progress") << "\n";
+				}
+			}
+
+			//case one shard is to be compacted, the other shards keep working
+			else if (command.word[1] == "SHARD")
+			{
+				int shard = shardNumber(command.word[2], memory, out);
+				if (shard >= 0)
+					memory.compactShard(shard);
+			}
+
+			//case memory is to be compacted moving as few bytes as possible, report against sliding
+			else if (command.word[1] == "PLAN")
+			{
+				LinkedList::CompactionReport report = memory.compactMemoryPlanned();
+				if (wal != NULL)
+					wal->append('P', "", 0, 0);
+				out << "Moved " << report.bytesMoved << " bytes in " << report.regionsMoved << " processes, C moves "
+						<< report.slideBytes << " bytes in " << report.slideRegions << " processes\n";
+			}
+
+			//case memory is to be compacted. Arena memory reports the cost of moving the bytes.
+			else if (command.word[1].empty())
+			{
+				std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+				long moved = memory.compactMemory(upperBound);
+				if (wal != NULL)
+					wal->append('C', "", upperBound, 0);
+				double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+				if (memory.isBacked())
+					out << "Compacted " << moved << " bytes in " << seconds << " seconds ("
+							<< (seconds > 0 ? moved / seconds / 1048576 : 0) << " MB/s)\n";
+			}
+			else
+				out << "Invalid Input. Enter HELP for more information.\n";
+			break;
+		}
+
+		//case memory status is to be printed, JSON lines case the last word asks for them
+		case OP_STAT:
+		{
+			bool json = command.word[1] == "JSON" || command.word[3] == "JSON";
+			Address from = 0;
+			Address to = LLONG_MAX;
+			if (command.word[1] == "SHARD")
+			{
+				int shard = shardNumber(command.word[2], memory, out);
+				if (shard >= 0)
+					memory.writeShard(out, shard, from, to, json);
+			}
+
+			//case a range of addresses, only the lines holding bytes in it are written
+			else if (!command.word[1].empty() && command.word[1] != "JSON")
+			{
+				if (!parseNumber(command.word[1], from) || !parseNumber(command.word[2], to) || from < 0 || to < from)
+					out << "Request rejected, STAT needs the first and last address of the range. Enter HELP for more information.\n";
+				else
+					memory.write(out, from, to, json);
+			}
+			else
+				memory.write(out, from, to, json);
+			break;
+		}
+
+		//case the processes are to be saved in a snapshot file
+		case OP_SAVE:
+			if (command.word[1].empty())
+				out << "Request rejected, SAVE needs a file name. Enter HELP for more information.\n";
+			else if (!memory.save(std::string(command.word[1])))
+				out << "Could not save to " << command.word[1] << ". Memory with --slabs, --buddy or --shards can not be saved. Enter HELP for more information.\n";
+			break;
+
+		//case the memory health is to be printed, without walking the processes
+		case OP_METRICS:
+		{
+			Memory::Metrics metrics = memory.metrics();
+			out << "Used " << metrics.usedBytes << " bytes, free " << metrics.freeBytes << " bytes\n"
+					<< "Regions " << metrics.regions << ", free gaps " << metrics.gaps << ", largest free block " << metrics.largestFree << " bytes\n"
+					<< "External fragmentation " << metrics.fragmentation * 100 << "%\n"
+					<< "Allocations " << metrics.allocations << ", failed " << metrics.failedAllocations << ", releases " << metrics.releases << "\n"
+					<< "Resizes " << metrics.resizes << ", in place " << metrics.resizesInPlace << "\n";
+			break;
+		}
+
+		//case a client wants to know the commands it sent before were run
+		case OP_PING:
+			out << "PONG\n";
+			break;
+
+		// case the program is to terminate
+		case OP_QUIT:
+			out << "\nAllocator terminated\n";
+			return true;
+
+		//catch all 
+		default:
+			out << "Invalid Input. Enter HELP for more information.\n";
+			break;
+		}
+
+		//case compaction runs in the background of the commands, take one step
+		if (autoCompactBudget > 0 && !memory.isCompacting() && !memory.isCompacted())
+		{
+			int regions = 0;
+			memory.compactMemoryStep(autoCompactBudget, regions);
+			if (wal != NULL)
+				wal->append('S', "", 0, autoCompactBudget);
+		}
+
+		//case the background compaction is built, publish it between commands
+		Memory::CompactionSwap swap;
+		if (memory.isCompacting() && memory.publishCompaction(false, swap))
+			writeSwap(swap, out);
+
+		//case enough commands were logged, save a checkpoint so recovery replays less
+		if (wal != NULL && wal->checkpointDue() && !wal->checkpoint(memory))
+			out << "WARNING: Could not write the checkpoint, the log keeps growing.\n";
+		return false;
+	}
+
+	/**
+	 * commitLog - commits the write-ahead log, case commands are logged. Returns
+	 * false and warns the user case it can not be written, no more commands
+	 * must be taken then.
 	 */
-	void compactMemory(int lastByte)
+	bool commitLog()
 	{
-		processes.compactProcesses(lastByte);
+		if (wal == NULL || wal->commit())
+			return true;
+		std::cout << "\nERROR: Could not write the write-ahead log " << walFile << ", the last commands may be lost. Stopping.\n";
+		return false;
 	}
 
-}; //end of Memory class 
-
-//=================================================================
-
-/**
- * class Allocator - Defines the behavior of a memory allocator app
- */ 
-class Allocator
-{
-private:
 	/**
-	 * parseUserInput - Process and validates a line of input from
-	 * the user. Returns an array of strings with data entered by 
-	 * the user. Trims spaces and tabs from beginning, end, and multiple spaces between commands.
-	 * Also trims tabs. Best to have no spaces in beginning and end, and just
-	 * a space between words in same command. Nice flow for the custom method.
-	 */ 
-	std::string * parseUserInput(std::string userInput)
+	 * runBatch - replays commands from the replay file, or from standard input
+	 * when there is none, without prompts. Input is read in large blocks and
+	 * replies are collected in one buffered writer. A summary with the number
+	 * of commands and the throughput is printed to the error stream at the end.
+	 */
+	int runBatch(Memory & memory, Address upperBound)
 	{
-		//array for the results, initiate all to empty.
-		std::string *result = new std::string[4];
-		for (int i = 0; i < 4; i++)
-			result[i] = "";
+		//open the input, standard input case there is no replay file
+		int fd = 0;
+		if (!replayFile.empty())
+		{
+			fd = open(replayFile.c_str(), O_RDONLY);
+			if (fd < 0)
+			{
+				std::cout << "\nERROR: Could not open replay file " << replayFile << "\n";
+				return -1;
+			}
+		}
+
+		const std::size_t blockSize = 1 << 20;
+		BufferedWriter writer(1, blockSize);
+		std::ostream out(&writer);
 
-		//skip any possible leading blanks
-		int place = 0;
-		char x = userInput[place++];
-		while ((x == ' ' || x == '\t') && place < userInput.size() + 1)
-			x = userInput[place++];
+		char * block = new char[blockSize];
+		std::string line;       //partial line carried between blocks
+		long commands = 0;
+		bool done = false;
+		bool logged = true;     //false once the log can not be written
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
 
-		//get the first space delimited entry
-		while (x != ' ' && x != '\t' && place < userInput.size() + 1)
+		//read blocks and execute every complete line in them
+		ssize_t bytes;
+		while (!done && (bytes = read(fd, block, blockSize)) > 0)
 		{
-			result[0] += x;
-			x = userInput[place++];
-		}
+			char * cursor = block;
+			char * end = block + bytes;
+			while (!done && cursor < end)
+			{
+				char * newline = (char *) memchr(cursor, '\n', end - cursor);
+				if (newline == NULL)
+				{
+					line.append(cursor, end - cursor);
+					break;
+				}
 
-		//check if it is a one entry command, if so return array with it.
-		if (strcmp(result[0].c_str(), "STAT") == 0 ||
-				strcmp(result[0].c_str(), "C") == 0 ||
-				strcmp(result[0].c_str(), "QUIT") == 0 ||
-				strcmp(result[0].c_str(), "HELP") == 0)
-			return result;
+				//case the whole line is in the block, parse it in place
+				if (line.empty())
+					done = executeCommand(parseUserInput(std::string_view(cursor, newline - cursor)), memory, upperBound, out);
+				else
+				{
+					line.append(cursor, newline - cursor);
+					done = executeCommand(parseUserInput(line), memory, upperBound, out);
+					line.clear();
+				}
+				cursor = newline + 1;
+				commands++;
+			}
 
-		//skip multiple spaces between entries
-		while ((x == ' ' || x == '\t') && place < userInput.size() + 1)
-			x = userInput[place++];
+			//the commands of a block are one group of the log
+			logged = commitLog();
+			done = done || !logged;
+		}
 
-		//get the second entry
-		while (x != ' ' && x != '\t' && place < userInput.size() + 1)
+		//last line may not end with a new line
+		if (!done && !line.empty())
 		{
-			result[1] += x;
-			x = userInput[place++];
+			executeCommand(parseUserInput(line), memory, upperBound, out);
+			commands++;
+			logged = commitLog();
 		}
+		out.flush();
 
-		// check it it is a two entry command, if so return array.
-		if (strcmp(result[0].c_str(), "RL") == 0)
-			return result;
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		std::cerr << "Replayed " << commands << " commands in " << seconds << " seconds ("
+				<< (seconds > 0 ? commands / seconds : 0) << " commands/sec)\n";
+
+		delete [] block;
+		if (fd != 0)
+			close(fd);
+		return logged ? 0 : -1;
+	}
 
-		//skip possible blanks between entries
-		while ((x == ' ' || x == '\t') && place < userInput.size() + 1)
-			x = userInput[place++];
+	/*
+	 * executeBatch - applies the count operations of a binary batch to memory and
+	 * appends the reply frame to output. Logs the operations that changed memory
+	 * and, like executeCommand, takes the compaction step and the checkpoint due.
+	 */
+	void executeBatch(const WireOp * ops, int count, Memory & memory, std::string & output)
+	{
+		batchResults.resize(count);
+		Address * results = batchResults.data();
+		memory.applyBatch(ops, count, results);
+		WireHeader header;
+		memcpy(header.magic, wireReply, sizeof(header.magic));
+		header.count = count;
+		output.append((const char *) &header, sizeof(header));
+		output.append((const char *) results, count * sizeof(Address));
 
-		//get third entry, case it  it a RQ
-		while (x != ' ' && x != '\t' && place < userInput.size() + 1)
+		if (wal != NULL)
+		{
+			for (int i = 0; i < count; i++)
+			{
+				if (ops[i].op == 'R' && results[i] >= 0)
+					wal->append('R', memory.wireName(ops[i].id), results[i], ops[i].size);
+				else if (ops[i].op == 'L' && results[i] == 0)
+					wal->append('L', memory.wireName(ops[i].id), 0, 0);
+			}
+		}
+		if (autoCompactBudget > 0 && !memory.isCompacting() && !memory.isCompacted())
 		{
-			result[2] += x;
-			x = userInput[place++];
+			int regions = 0;
+			memory.compactMemoryStep(autoCompactBudget, regions);
+			if (wal != NULL)
+				wal->append('S', "", 0, autoCompactBudget);
 		}
 
-		//skips possible blanks between entries
-		while ((x == ' ' || x == '\t') && place < userInput.size() + 1)
-			x = userInput[place++];
+		//the reply is a frame, so a background compaction is published without a report
+		Memory::CompactionSwap swap;
+		if (memory.isCompacting())
+			memory.publishCompaction(false, swap);
+		if (wal != NULL && wal->checkpointDue() && !wal->checkpoint(memory))
+			output += "WARNING: Could not write the checkpoint, the log keeps growing.\n";
+	}
 
-		//get fourth entry
-		while (x != ' ' && x != '\t' && place < userInput.size() + 1)
+	/*
+	 * serveInput - reads what connection sent, executes every complete line and
+	 * binary batch and collects the replies in its output. Reads up to readBudget
+	 * bytes and stops once the output holds outputLimit bytes, so a client that
+	 * pipelines fast does not starve the others, what is left is read on the next
+	 * wakeup. A line longer than lineLimit closes the connection. Returns the number of
+	 * commands executed, counting every operation of a batch.
+	 */
+	long serveInput(Connection * connection, Memory & memory, Address upperBound)
+	{
+		char block[65536];
+		long commands = 0;
+		std::size_t readBytes = 0;
+		StringSink sink(connection->output);
+		std::ostream out(&sink);
+		while (!connection->closing && readBytes < readBudget && connection->output.size() < outputLimit)
 		{
-			result[3] += x;
-			x = userInput[place++];
+			ssize_t bytes = read(connection->fd, block, sizeof(block));
+			if (bytes < 0 && errno == EINTR)
+				continue;
+			if (bytes <= 0)
+			{
+				//case the client hung up, otherwise nothing is left to read
+				if (bytes == 0 || (errno != EAGAIN && errno != EWOULDBLOCK))
+					connection->closing = true;
+				break;
+			}
+
+			//the lines and batches in the block, the first one may start in the input left before
+			readBytes += bytes;
+			connection->input.append(block, bytes);
+			std::size_t start = 0;
+			std::size_t newline;
+			while (!connection->closing && start < connection->input.size())
+			{
+				//case a binary batch, wait until the whole frame is in
+				if (connection->input[start] == 0)
+				{
+					WireHeader header;
+					if (connection->input.size() - start < sizeof(header))
+						break;
+					memcpy(&header, &connection->input[start], sizeof(header));
+					if (memcmp(header.magic, wireRequest, sizeof(header.magic)) != 0 || header.count < 0 || header.count > wireBatch)
+					{
+						out << "Invalid batch frame, closing the connection.\n";
+						connection->closing = true;
+						break;
+					}
+					std::size_t frameBytes = sizeof(header) + header.count * sizeof(WireOp);
+					if (connection->input.size() - start < frameBytes)
+						break;
+
+					//the frame may sit at any offset of the input, copy the operations out aligned
+					batch.resize(header.count);
+					memcpy(batch.data(), &connection->input[start + sizeof(header)], header.count * sizeof(WireOp));
+					executeBatch(batch.data(), header.count, memory, connection->output);
+					start += frameBytes;
+					commands += header.count;
+					continue;
+				}
+
+				newline = connection->input.find('\n', start);
+				if ((newline == std::string::npos ? connection->input.size() : newline) - start > lineLimit)
+				{
+					out << "Line longer than " << lineLimit << " bytes, closing the connection.\n";
+					connection->closing = true;
+					break;
+				}
+				if (newline == std::string::npos)
+					break;
+				if (executeCommand(parseUserInput(std::string_view(connection->input).substr(start, newline - start)), memory, upperBound, out))
+					connection->closing = true;
+				start = newline + 1;
+				commands++;
+			}
+			connection->input.erase(0, start);
 		}
-		//finally return array with four entries. 
-		return result;
+		return commands;
 	}
 
-	/**
-	 * printUsage - returns a string with usage contents for the user. This can be accessed 
-	 * during app execution with -help argument or by entering HELP to allocator>  during
-	 * the program runtime, which does not halt the execution.
-	 */ 
-	std::string printUsage()
+	/*
+	 * serveOutput - writes the replies of connection until the socket takes no more.
+	 * Returns false case the client can not take replies anymore.
+	 */
+	bool serveOutput(Connection * connection)
 	{
-		std::stringstream ss;
-		ss <<
-				"\n	This project simulates a linear memory allocator application. The memory is initially\n" <<
-				"	set to have its first byte at location 0 and last available memory byte is \n" <<
-				"	represented by the integer passed as program argument during execution, minus 1. When \n" <<
-				"	the program loads, the user sees the prompt 'allocator >' to which the user can\n" <<
-				"	input commands like the following space separated or tab separated example commands in a line:\n\n" <<
-				"	a. RQ P3 1024 B	Requests memory for P3 using best fit strategy for 1024 bytes allocation.\n" <<
-				"			Case there is not enough memory, user is warned, and request is rejected.\n\n" <<
-				"	b. RL P3	Releases the memory allocated to P3.\n" <<
-				"			Case P3 is not a valid allocated process name, the user is warned and release command is rejected.\n\n" <<
-				"	c. STAT		Prints status of memory, start and final byte, and process name or FREE if memory is not allocated .\n\n" <<
-				"	d. C		Compacts the memory by shifting free space towards the higher bytes in memory.\n\n" <<
-				"	e. QUIT		Quits the program.\n\n" <<
-				"	f. HELP		Prints program usage during runtime, program does not quit.\n\n" <<
-				"	Note: All commands are case sensitive and should not contain spaces in the beginning or \n" <<
-				"	      end of input line for guaranteed execution. For this project, B strategy, best fit, is the only option and any other value\n" <<
-				"	      passed other than B for the fourth item of RQ will cause allocation to be rejected. Multiple space and tab trimming\n" <<
-				"	      for input line was implemented, but single space separation between entries in the line is still preferred for optimal execution.\n\n" <<
-				"	Usage:  Instruction for how to run the program:\n" <<
-				"			g++ -c allocator_VMachado.cpp          Compiles the source code in to object file\n" <<
-				"			g++ -c VMapp.exe allocator_VMachado.o  Links the object file to executable.\n" <<
-				"			./VMapp.exe 1048576                    Runs and allocates 1MB for the allocator app.\n" <<
-				"			./VMapp.exe -help                      Prints usage information\n\n" <<
-				"			PS: 1MB is lowest value allowed and will get overwritten to 1048576. Any value\n" <<
-				"			    over 1048576 will extend memory allocation.\n\n" <<
-				"	Memory slot range: [ 0      :   argv[1] - 1 ] \n\n"  <<
-				"	Where argv[1] is argument passed when executing the program and \n" <<
-				"	which lowest value can be 1048576, representing 1MB.\n\n";
-		return ss.str();
+		std::size_t sent = 0;
+		while (sent < connection->output.size())
+		{
+			ssize_t written = write(connection->fd, connection->output.data() + sent, connection->output.size() - sent);
+			if (written < 0 && errno == EINTR)
+				continue;
+			if (written < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+				break;
+			if (written <= 0)
+				return false;
+			sent += written;
+		}
+		connection->output.erase(0, sent);
+		return true;
 	}
 
 	/**
-	 * validateArguments - validates the arguments passed in by the user 
-	 * when executing the program. Possible arguments are -help for the 
-	 * usage information OR a integer greater than 1048576 as the high
-	 * byte for the memory cluster. Any value lower to this will default to 1048576
-	 * while any value greater than it will extend memory available for allocation.
-	 */ 
-	int validateArguments(int count, char ** values)
+	 * runServer - serves the commands of many clients on the serve address from one
+	 * thread, waiting on all the sockets with epoll. Clients may pipeline commands,
+	 * every complete line or binary batch they sent is executed as it arrives and
+	 * the replies go back in order. The commands of one wakeup are one group of the log, committed
+	 * before any reply is sent. A client that does not take its replies is not read
+	 * until it does. QUIT closes that client only, SIGINT or SIGTERM stop the server.
+	 * Returns -1 case the log can not be written, the server stops without replying then.
+	 */
+	int runServer(Memory & memory, Address upperBound)
 	{
-		//no argument passed. I guess i could also default to 1048576, user should read info!
-		if(count == 1)
+		int listener = openSocket(serveAddress, true);
+		int poller = listener < 0 ? -1 : epoll_create1(0);
+		if (poller < 0)
+		{
+			std::cout << "\nERROR: Could not listen on " << serveAddress << "\n";
+			if (listener >= 0)
+				close(listener);
 			return -1;
+		}
+		fcntl(listener, F_SETFL, O_NONBLOCK);
+		epoll_event event;
+		event.events = EPOLLIN;
+		event.data.ptr = NULL;     //NULL marks the listener
+		epoll_ctl(poller, EPOLL_CTL_ADD, listener, &event);
 
-		//usage information
-		else if(strcmp(values[1], "-help") == 0)
-			return -2;
+		//stop on SIGINT and SIGTERM, interrupting epoll_wait, and survive clients that hang up
+		struct sigaction action;
+		memset(&action, 0, sizeof(action));
+		action.sa_handler = stopServing;
+		sigaction(SIGINT, &action, NULL);
+		sigaction(SIGTERM, &action, NULL);
+		signal(SIGPIPE, SIG_IGN);
+		std::cerr << "Serving on " << serveAddress << "\n";
 
-		//attempt to parse argument as integer and catch exception case it fails
-		else
+		std::vector<Connection *> connections;
+		std::vector<Connection *> touched;
+		epoll_event events[256];
+		long commands = 0;
+		long clients = 0;
+		int status = 0;
+		serverStopping = 0;
+		while (!serverStopping)
 		{
-			int input = 0;
-			try
+			int ready = epoll_wait(poller, events, 256, -1);
+			if (ready < 0)
 			{
-				input = stoi(std::string(values[1]));
+				if (errno == EINTR)
+					continue;
+				break;
 			}
-			//if the value passed is not -help nor an integer, error occurs. Halt. Houston, we have a problem!
-			catch(const std::invalid_argument &x)
+
+			//accept new clients and run what the others sent
+			touched.clear();
+			for (int e = 0; e < ready; e++)
 			{
-				std::cout << "\nERROR: Argument must be an integer or -help. Low values default to 1048576, or 1MB\n";
-				std::cout << "        ***  " << x.what() << "  ***\n";
-				return -1;
+				Connection * connection = (Connection *) events[e].data.ptr;
+				if (connection == NULL)
+				{
+					int fd;
+					while ((fd = accept4(listener, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0)
+					{
+						connection = new Connection;
+						connection->fd = fd;
+						connection->closing = false;
+						event.events = EPOLLIN;
+						event.data.ptr = connection;
+						epoll_ctl(poller, EPOLL_CTL_ADD, fd, &event);
+						connections.push_back(connection);
+						clients++;
+					}
+					continue;
+				}
+				if (connection->output.empty())
+					commands += serveInput(connection, memory, upperBound);
+				touched.push_back(connection);
+			}
+
+			//the log is on disk before any client hears its command was run
+			if (!commitLog())
+			{
+				status = -1;
+				break;
+			}
+
+			//send the replies, waiting for room case a client does not take them all
+			for (std::size_t i = 0; i < touched.size(); i++)
+			{
+				Connection * connection = touched[i];
+				bool open = serveOutput(connection);
+				if (!open || (connection->closing && connection->output.empty()))
+				{
+					close(connection->fd);
+					connections.erase(std::find(connections.begin(), connections.end(), connection));
+					delete connection;
+					continue;
+				}
+				event.events = connection->output.empty() ? EPOLLIN : EPOLLOUT;
+				event.data.ptr = connection;
+				epoll_ctl(poller, EPOLL_CTL_MOD, connection->fd, &event);
 			}
-			if(input > 1048576)
-				return input;
 		}
-		return 1048576;
+
+		for (std::size_t i = 0; i < connections.size(); i++)
+		{
+			close(connections[i]->fd);
+			delete connections[i];
+		}
+		close(poller);
+		close(listener);
+		if (serveAddress.find_first_not_of("0123456789") != std::string::npos)
+			unlink(serveAddress.c_str());
+		std::cerr << "Served " << commands << " commands from " << clients << " clients\n";
+		return status;
 	}
 
 public:
@@ -648,18 +6315,36 @@ public:
 	 */
 	Allocator()
 {
-	 //nothing special
+	 batchMode = false;
+	 arenaMode = false;
+	 slabMode = false;
+	 buddyZoneBytes = 0;
+	 autoCompactBudget = 0;
+	 shardCount = 0;
+	 benchMode = false;
+	 checkpointEvery = 0;
+	 wal = NULL;
 }
+
+	/**
+	 * Allocator destructor - commits and closes the write-ahead log, if any
+	 */
+	~Allocator()
+	{
+		delete wal;
+	}
+
 	/**
 	 * run - runs the memory allocator with the arguments passed in by the user.
 	 * Arguments are parsed, validated and used if they are well formatted. Error 
 	 * messages will be provided case the arguments are invalid. Wrong commands passed
 	 * during runtime do not halt execution, instead the provide error messages. 
+	 * With --replay or --pipe the commands are executed in batch mode instead.
 	 */
 	int run(int count, char ** values)
 	{
 		//validate arguments
-		int upperBound = validateArguments(count, values);
+		Address upperBound = validateArguments(count, values);
 
 		//case no argument
 		if (upperBound == -1)
@@ -675,8 +6360,58 @@ public:
 			return -1;
 		}
 
+		//case options after the memory size are not valid
+		if (!parseOptions(count, values, upperBound))
+			return -1;
+
+		//case this run drives a server instead of holding a memory
+		if (!clientAddress.empty())
+			return loadGenerator.run(clientAddress, std::cout);
+
 		 //subtract for max - 1 requirement
-		Memory memory(--upperBound);
+		Memory memory(--upperBound, arenaMode);
+		if (arenaMode && !memory.isBacked())
+			std::cout << "WARNING: Could not reserve the arena, addresses are only simulated.\n";
+		Address covered = 0;
+		if (!loadFile.empty() && !memory.load(loadFile, covered))
+		{
+			std::cout << "\nERROR: Could not load " << loadFile << ", it is not a snapshot or does not fit in memory. See usage.\n";
+			return -1;
+		}
+
+		//case commands are logged, recover what the log holds before taking new ones
+		if (!walFile.empty())
+		{
+			long replayed = 0;
+			wal = new WriteAheadLog(walFile, checkpointEvery);
+			if (!wal->recover(memory, replayed))
+			{
+				std::cout << "\nERROR: Could not recover from " << walFile << ", the log or its checkpoint does not match the memory. See usage.\n";
+				return -1;
+			}
+			std::cerr << "Recovered " << replayed << " logged commands from " << walFile << "\n";
+		}
+		if (shardCount > 0)
+			memory.enableShards(shardCount);
+		if (slabMode)
+			memory.enableSizeClasses();
+		if (buddyZoneBytes > 0)
+			memory.enableBuddy(buddyZoneBytes);
+
+		//case the synthetic benchmark is run instead of commands
+		if (benchMode)
+		{
+			benchmark.run(memory, upperBound, std::cout);
+			return 0;
+		}
+
+		//case commands come from a trace file or a pipe
+		if (batchMode)
+			return runBatch(memory, upperBound);
+
+		//case commands come from clients over sockets
+		if (!serveAddress.empty())
+			return runServer(memory, upperBound);
 
 		//controls the end of loop 
 		bool done = false;
@@ -684,106 +6419,21 @@ public:
 		//stores the user input line
 		std::string userInput;
 
-		//loop while command != QUIT
+		//loop while command != QUIT, or until input ends
 		while (!done)
 		{
 			//display prompt and collect input from user
 			userInput = "";
 			std::cout << "allocator> ";
-			std::getline(std::cin, userInput);
-
-			//process the input from the user
-			std::string *result = parseUserInput(userInput);
-
-			//case a memory request
-			if (strcmp(result[0].c_str(), "RQ") == 0)
-			{
-				//must be best fit strategy
-				if(result[3].compare("B") == 0)
-				{
-					//attemPt to parse third entry as integer, reject command if it fails.
-					int size;
-					bool error = false;
-					try
-					{
-						//attempted parse
-						size = stoi(result[2]);
-					}
-					catch(const std::invalid_argument &x)
-					{
-						error = true;
-					}
-					//reject user command case process does not have an integer size
-					if(error || size <= 0)
-						std::cout << "Request rejected, third parameter must be a positive integer. Enter HELP for more information.\n";
-
-					//otherwise attempt to allocate memory for request. If there is enough memory, memory is allocated
-					//else command is rejected and user is warned.
-					else
-					{
-						int slot = memory.findMemorySlot(size);
-
-						//case not enough memory
-						if (slot == -1)
-						{
-							std::cout << "There is not enough memory to load " << result[2] << " bytes. Enter HELP for more information.\n";
-						}
-
-						//case there is a slot with enough memory, allocate
-						else
-						{
-							memory.addProcessToMemory(new Process(result[1], size), slot);
-						}
-					}
-				}
-
-				// case B is not the allocation strategy passes by the user
-				else
-				{
-					std::cout << "Invalid Parameter for Allocation Strategy, \'B\' is only option. Enter HELP for more information.\n";
-				}
-			}
-
-			//case user asks for help, usage information is printed
-			else if (strcmp(result[0].c_str(), "HELP") == 0)
-			{
-				std::cout << printUsage();
-			}
-
-			// case command is to release memory, attempt to release
-			else if (strcmp(result[0].c_str(), "RL") == 0)
-			{
-				bool done = memory.removeProcessFromMemory(result[1]);
-
-				//case process name does not exist, user is warned and command rejected
-				if(!done)
-					std::cout << "Process does not exist. Enter HELP for more information.\n";
-			}
-
-			//case memory is to be compacted
-			else if (strcmp(result[0].c_str(), "C") == 0)
-			{
-				memory.compactMemory(upperBound);
-			}
-
-			//case memory status is to be printed
-			else if (strcmp(result[0].c_str(), "STAT") == 0)
-			{
-				std::cout << memory.toString();
-			}
-
-			// case the program is to terminate
-			else if (strcmp(result[0].c_str(), "QUIT") == 0)
-			{
-				done = true;
-				std::cout << "\nAllocator terminated\n";
-			}
+			if (!std::getline(std::cin, userInput))
+				break;
 
-			//catch all 
-			else
-			{
-				std::cout << "Invalid Input. Enter HELP for more information.\n";
-			}
+			//process the input from the user, the log is on disk before the reply is shown
+			std::stringstream reply;
+			done = executeCommand(parseUserInput(userInput), memory, upperBound, reply);
+			if (!commitLog())
+				return -1;
+			std::cout << reply.str();
 		}
 		return 0;
 	}